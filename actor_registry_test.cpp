@@ -0,0 +1,75 @@
+#include "game.h"
+
+#include <iostream>
+#include <vector>
+
+using std::cerr;
+using std::endl;
+using std::vector;
+
+static int failures = 0;
+
+static void expect(bool condition, const char* what) {
+    if (condition) return;
+    cerr << "failed: " << what << endl;
+    ++failures;
+}
+
+static vector<int> ids_of(const ActorRegistry& actors) {
+    vector<int> ids;
+    for (auto& actor : actors)
+        ids.push_back(actor.id);
+    return ids;
+}
+
+// Handles of removed actors must go stale for good, even once their slots are reused, while the handles and
+// order of the actors kept survive compaction
+int main() {
+    ActorRegistry actors;
+    vector<ActorHandle> handles;
+    for (int id = 0; id < 8; ++id)
+        handles.push_back(actors.add(Actor{id, {}, 2, 2, 2, 3}));
+    expect(actors.size() == 8, "eight actors added");
+
+    // Removal is a tombstone: the actor is skipped but its handle still reaches it until compact()
+    actors.remove(handles[1]);
+    actors.remove(handles[4]);
+    actors.remove(handles[7]);
+    expect(actors.size() == 5, "three removed");
+    expect(!actors.contains(handles[4]), "a removed actor is not contained");
+    expect(ids_of(actors) == vector<int>({0, 2, 3, 5, 6}), "iteration skips the removed");
+    expect(actors[handles[4]].id == 4, "a removed actor stays in place until compact()");
+
+    actors.compact();
+    expect(ids_of(actors) == vector<int>({0, 2, 3, 5, 6}), "compaction keeps the order");
+    for (int id : {0, 2, 3, 5, 6}) {
+        expect(actors.contains(handles[id]), "a kept handle survives compaction");
+        expect(actors[handles[id]].id == id, "a kept handle still names its actor");
+        expect(actors.handle(actors[handles[id]]) == handles[id], "handle() gives back the same handle");
+    }
+    for (int id : {1, 4, 7})
+        expect(!actors.contains(handles[id]), "a removed handle is stale after compaction");
+
+    // New actors reuse the freed slots under a new generation, so the old handles stay stale
+    vector<ActorHandle> added;
+    for (int id = 8; id < 12; ++id)
+        added.push_back(actors.add(Actor{id, {}, 2, 2, 2, 3}));
+    expect(actors.slot_count() == 9, "three slots are reused before a new one is made");
+    for (int id : {1, 4, 7})
+        expect(!actors.contains(handles[id]), "a reused slot does not revive an old handle");
+    for (size_t i = 0; i < added.size(); ++i) {
+        expect(actors.contains(added[i]), "a new handle is contained");
+        expect(actors[added[i]].id == 8 + (int) i, "a new handle names its actor");
+    }
+    expect(ids_of(actors) == vector<int>({0, 2, 3, 5, 6, 8, 9, 10, 11}), "new actors are stored at the end");
+
+    // Removing everything and compacting leaves an empty registry whose every handle is stale
+    for (auto& actor : actors)
+        actors.remove(actors.handle(actor));
+    actors.compact();
+    expect(actors.empty(), "everything removed");
+    for (auto handle : added)
+        expect(!actors.contains(handle), "no handle survives emptying the registry");
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,201 @@
+#include "actor_store.h"
+
+#include <cassert>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+ActorStore::ActorStore(std::pmr::memory_resource* resource)
+        : stone_counts(resource), scissor_counts(resource), paper_counts(resource), star_counts(resource),
+          ids(resource), names(resource) {}
+
+ActorStore::ActorStore(const ActorRegistry& actors, std::pmr::memory_resource* resource) : ActorStore(resource) {
+    reserve(actors.size());
+    for (auto& actor : actors)
+        push_back(actor);
+}
+
+void ActorStore::reserve(size_t count) {
+    stone_counts.reserve(count);
+    scissor_counts.reserve(count);
+    paper_counts.reserve(count);
+    star_counts.reserve(count);
+    ids.reserve(count);
+    names.reserve(count);
+}
+
+void ActorStore::push_back(const Actor& actor) {
+    ids.push_back(actor.id);
+    names.push_back(actor.name);
+    stone_counts.emplace_back();
+    scissor_counts.emplace_back();
+    paper_counts.emplace_back();
+    star_counts.emplace_back();
+    set(size() - 1, actor);
+}
+
+Actor ActorStore::get(size_t index) const {
+    return Actor{ids[index], names[index],
+                 stone_counts[index], scissor_counts[index], paper_counts[index],
+                 star_counts[index]};
+}
+
+bool ActorStore::fits(const Actor& actor) {
+    auto fits_byte = [](int count) { return count >= 0 && count <= UINT8_MAX; };
+    return fits_byte(actor.stone_count) && fits_byte(actor.scissor_count) && fits_byte(actor.paper_count) &&
+           actor.star_count >= INT16_MIN && actor.star_count <= INT16_MAX;
+}
+
+void ActorStore::set(size_t index, const Actor& actor) {
+    // Games start with a few cards each, so a byte per counter is plenty; callers keep anything larger out
+    assert(fits(actor));
+
+    ids[index] = actor.id;
+    names[index] = actor.name;
+    stone_counts[index] = (uint8_t) actor.stone_count;
+    scissor_counts[index] = (uint8_t) actor.scissor_count;
+    paper_counts[index] = (uint8_t) actor.paper_count;
+    star_counts[index] = (int16_t) actor.star_count;
+}
+
+// The hand of an actor without touching its name
+static Actor hand_of(const ActorStore& store, size_t index) {
+    return Actor{store.ids[index], {},
+                 store.stone_counts[index], store.scissor_counts[index], store.paper_counts[index],
+                 store.star_counts[index]};
+}
+
+// Every kernel below mirrors actor_predict_success/actor_predict_fail operation by operation,
+// so that the vectorized wills are bit-identical to the scalar ones. That also takes the compiler not
+// contracting either side into fused multiply-adds, see the -ffp-contract=off
+// block in CMakeLists.txt.
+
+#if defined(__AVX2__)
+
+static __m256i load_counts(const uint8_t* counts) {
+    return _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*) counts));
+}
+
+// Returns how many leading actors were handled
+static size_t compute_compete_wills_simd(const CardCounts& counts, const ActorStore& store, float* wills) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i global_stone = _mm256_set1_epi32(counts.stone_count);
+    const __m256i global_scissor = _mm256_set1_epi32(counts.scissor_count);
+    const __m256i global_paper = _mm256_set1_epi32(counts.paper_count);
+    const __m256i global_total = _mm256_set1_epi32(counts.total_count());
+
+    size_t i = 0;
+    for (; i + 8 <= store.size(); i += 8) {
+        __m256i stone = load_counts(&store.stone_counts[i]);
+        __m256i scissor = load_counts(&store.scissor_counts[i]);
+        __m256i paper = load_counts(&store.paper_counts[i]);
+
+        __m256i total = _mm256_sub_epi32(global_total, _mm256_add_epi32(_mm256_add_epi32(stone, scissor), paper));
+        __m256 total_f = _mm256_cvtepi32_ps(total);
+        __m256 empty = _mm256_castsi256_ps(_mm256_cmpeq_epi32(total, zero));
+
+        __m256 prob_stone = _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(global_stone, stone)), total_f);
+        __m256 prob_scissor = _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(global_scissor, scissor)), total_f);
+        __m256 prob_paper = _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(global_paper, paper)), total_f);
+        prob_stone = _mm256_andnot_ps(empty, prob_stone);
+        prob_scissor = _mm256_andnot_ps(empty, prob_scissor);
+        prob_paper = _mm256_andnot_ps(empty, prob_paper);
+
+        __m256 has_stone = _mm256_castsi256_ps(_mm256_cmpgt_epi32(stone, zero));
+        __m256 has_scissor = _mm256_castsi256_ps(_mm256_cmpgt_epi32(scissor, zero));
+        __m256 has_paper = _mm256_castsi256_ps(_mm256_cmpgt_epi32(paper, zero));
+
+        __m256 beat_stone = _mm256_and_ps(has_paper, _mm256_mul_ps(prob_stone, prob_stone));
+        __m256 beat_scissor = _mm256_and_ps(has_stone, _mm256_mul_ps(prob_scissor, prob_scissor));
+        __m256 beat_paper = _mm256_and_ps(has_scissor, _mm256_mul_ps(prob_paper, prob_paper));
+        __m256 success = _mm256_add_ps(_mm256_add_ps(beat_stone, beat_scissor), beat_paper);
+
+        __m256 fail_stone = _mm256_and_ps(has_scissor, _mm256_mul_ps(prob_stone, prob_paper));
+        __m256 fail_scissor = _mm256_and_ps(has_paper, _mm256_mul_ps(prob_scissor, prob_stone));
+        __m256 fail_paper = _mm256_and_ps(has_stone, _mm256_mul_ps(prob_paper, prob_scissor));
+        __m256 fail = _mm256_add_ps(_mm256_add_ps(fail_stone, fail_scissor), fail_paper);
+
+        _mm256_storeu_ps(wills + i, _mm256_sub_ps(success, fail));
+    }
+    return i;
+}
+
+#elif defined(__SSE2__) || defined(_M_X64)
+
+static __m128i load_counts(const uint8_t* counts) {
+    int32_t packed;
+    memcpy(&packed, counts, sizeof(packed));
+
+    const __m128i zero = _mm_setzero_si128();
+    __m128i words = _mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero);
+    return _mm_unpacklo_epi16(words, zero);
+}
+
+// Returns how many leading actors were handled
+static size_t compute_compete_wills_simd(const CardCounts& counts, const ActorStore& store, float* wills) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i global_stone = _mm_set1_epi32(counts.stone_count);
+    const __m128i global_scissor = _mm_set1_epi32(counts.scissor_count);
+    const __m128i global_paper = _mm_set1_epi32(counts.paper_count);
+    const __m128i global_total = _mm_set1_epi32(counts.total_count());
+
+    size_t i = 0;
+    for (; i + 4 <= store.size(); i += 4) {
+        __m128i stone = load_counts(&store.stone_counts[i]);
+        __m128i scissor = load_counts(&store.scissor_counts[i]);
+        __m128i paper = load_counts(&store.paper_counts[i]);
+
+        __m128i total = _mm_sub_epi32(global_total, _mm_add_epi32(_mm_add_epi32(stone, scissor), paper));
+        __m128 total_f = _mm_cvtepi32_ps(total);
+        __m128 empty = _mm_castsi128_ps(_mm_cmpeq_epi32(total, zero));
+
+        __m128 prob_stone = _mm_div_ps(_mm_cvtepi32_ps(_mm_sub_epi32(global_stone, stone)), total_f);
+        __m128 prob_scissor = _mm_div_ps(_mm_cvtepi32_ps(_mm_sub_epi32(global_scissor, scissor)), total_f);
+        __m128 prob_paper = _mm_div_ps(_mm_cvtepi32_ps(_mm_sub_epi32(global_paper, paper)), total_f);
+        prob_stone = _mm_andnot_ps(empty, prob_stone);
+        prob_scissor = _mm_andnot_ps(empty, prob_scissor);
+        prob_paper = _mm_andnot_ps(empty, prob_paper);
+
+        __m128 has_stone = _mm_castsi128_ps(_mm_cmpgt_epi32(stone, zero));
+        __m128 has_scissor = _mm_castsi128_ps(_mm_cmpgt_epi32(scissor, zero));
+        __m128 has_paper = _mm_castsi128_ps(_mm_cmpgt_epi32(paper, zero));
+
+        __m128 beat_stone = _mm_and_ps(has_paper, _mm_mul_ps(prob_stone, prob_stone));
+        __m128 beat_scissor = _mm_and_ps(has_stone, _mm_mul_ps(prob_scissor, prob_scissor));
+        __m128 beat_paper = _mm_and_ps(has_scissor, _mm_mul_ps(prob_paper, prob_paper));
+        __m128 success = _mm_add_ps(_mm_add_ps(beat_stone, beat_scissor), beat_paper);
+
+        __m128 fail_stone = _mm_and_ps(has_scissor, _mm_mul_ps(prob_stone, prob_paper));
+        __m128 fail_scissor = _mm_and_ps(has_paper, _mm_mul_ps(prob_scissor, prob_stone));
+        __m128 fail_paper = _mm_and_ps(has_stone, _mm_mul_ps(prob_paper, prob_scissor));
+        __m128 fail = _mm_add_ps(_mm_add_ps(fail_stone, fail_scissor), fail_paper);
+
+        _mm_storeu_ps(wills + i, _mm_sub_ps(success, fail));
+    }
+    return i;
+}
+
+#else
+
+static size_t compute_compete_wills_simd(const CardCounts&, const ActorStore&, float*) {
+    return 0;
+}
+
+#endif
+
+void compute_compete_wills(const CardCounts& counts, const ActorStore& store, float* wills) {
+    size_t i = compute_compete_wills_simd(counts, store, wills);
+
+    // Leftover actors that do not fill a whole register
+    for (; i < store.size(); ++i)
+        wills[i] = actor_compete_will(counts, hand_of(store, i));
+}
+
+void compute_compete_wills_scalar(const CardCounts& counts, const ActorStore& store, float* wills) {
+    for (size_t i = 0; i < store.size(); ++i)
+        wills[i] = actor_compete_will(counts, hand_of(store, i));
+}
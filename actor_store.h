@@ -0,0 +1,50 @@
+#ifndef ANIMAL_WORLD_ACTOR_STORE_H
+#define ANIMAL_WORLD_ACTOR_STORE_H
+
+#include "game.h"
+
+#include <vector>
+#include <memory_resource>
+#include <string_view>
+#include <cstdint>
+
+// Actors stored column by column. The counters that the AI reads every round sit in
+// narrow contiguous arrays; ids and names are kept apart since only display needs them.
+struct ActorStore {
+    std::pmr::vector<uint8_t> stone_counts;
+    std::pmr::vector<uint8_t> scissor_counts;
+    std::pmr::vector<uint8_t> paper_counts;
+    std::pmr::vector<int16_t> star_counts;
+
+    std::pmr::vector<int> ids;
+    std::pmr::vector<std::string_view> names;
+
+    // The columns draw from resource, so that a store built during a round can live in the round arena
+    explicit ActorStore(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    // Every actor of the registry that is not removed, in the registry's order; each must fit()
+    explicit ActorStore(const ActorRegistry& actors,
+                        std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    // Whether the actor's counters fit the narrow columns. set() and push_back() take only actors that do,
+    // since Rules, sweeps and snapshots all allow larger hands.
+    [[nodiscard]] static bool fits(const Actor& actor);
+
+    [[nodiscard]] size_t size() const { return ids.size(); }
+
+    void reserve(size_t count);
+
+    void push_back(const Actor& actor);
+
+    [[nodiscard]] Actor get(size_t index) const;
+
+    void set(size_t index, const Actor& actor);
+};
+
+// Write actor_compete_will of every actor in the store to wills, several actors per instruction
+void compute_compete_wills(const CardCounts& counts, const ActorStore& store, float* wills);
+
+// One actor at a time through actor_compete_will; the reference for the vectorized kernel
+void compute_compete_wills_scalar(const CardCounts& counts, const ActorStore& store, float* wills);
+
+#endif //ANIMAL_WORLD_ACTOR_STORE_H
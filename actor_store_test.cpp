@@ -0,0 +1,61 @@
+#include "actor_store.h"
+
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using std::cerr;
+using std::endl;
+using std::vector;
+
+// The vectorized wills must be bit-identical to the scalar ones, over random hands and global counts,
+// including stores whose size is not a multiple of the register width and hands that hold all the cards
+int main() {
+    std::mt19937 random(1);
+    auto count = std::uniform_int_distribution<int>(0, 12);
+    auto extra = std::uniform_int_distribution<int>(0, 60);
+
+    int failures = 0;
+    for (int trial = 0; trial < 200; ++trial) {
+        ActorStore store;
+        size_t size = (size_t) trial % 37;
+
+        CardCounts counts;
+        for (size_t i = 0; i < size; ++i) {
+            Actor actor{(int) i, {}, count(random), count(random), count(random), 3};
+            store.push_back(actor);
+            counts.stone_count = std::max(counts.stone_count, actor.stone_count);
+            counts.scissor_count = std::max(counts.scissor_count, actor.scissor_count);
+            counts.paper_count = std::max(counts.paper_count, actor.paper_count);
+        }
+        // Every fourth trial, some actor may hold every card of a kind, or all the cards in play
+        if (trial % 4 != 0) {
+            counts.stone_count += extra(random);
+            counts.scissor_count += extra(random);
+            counts.paper_count += extra(random);
+        }
+
+        vector<float> wills(size), expected(size);
+        compute_compete_wills(counts, store, wills.data());
+        compute_compete_wills_scalar(counts, store, expected.data());
+
+        for (size_t i = 0; i < size; ++i) {
+            if (memcmp(&wills[i], &expected[i], sizeof(float)) == 0) continue;
+            cerr << "trial " << trial << ", actor " << i << ": will " << wills[i] << ", expected " << expected[i]
+                 << endl;
+            ++failures;
+        }
+    }
+
+    // Hands past a byte per counter must be turned away rather than truncated
+    Actor small{0, {}, 255, 0, 3, 3};
+    Actor large{0, {}, 256, 0, 3, 3};
+    Actor in_debt{0, {}, 2, 2, 2, -3};
+    if (!ActorStore::fits(small) || ActorStore::fits(large) || !ActorStore::fits(in_debt)) {
+        cerr << "ActorStore::fits misjudges the column widths" << endl;
+        ++failures;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,405 @@
+#include "game.h"
+#include "actor_store.h"
+#include "thread_pool.h"
+#include "compete_ranking.h"
+#include "round_arena.h"
+
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <thread>
+#include <cstring>
+#include <cstdlib>
+#include <new>
+#include <optional>
+#include <sstream>
+#include <string>
+
+using std::cout;
+using std::cerr;
+using std::endl;
+using std::vector;
+
+// Every heap allocation the process makes, on any thread, so that a benchmark can tell whether a loop touches
+// the heap.
+// Profiling builds already replace operator new in the core library and count there.
+#ifdef ANIMAL_WORLD_PROFILE
+static long long heap_allocations() {
+    return profiled_heap_allocations();
+}
+#else
+static std::atomic<long long> heap_allocation_count{0};
+
+static long long heap_allocations() {
+    return heap_allocation_count.load(std::memory_order_relaxed);
+}
+
+void* operator new(size_t size) {
+    heap_allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* pointer = std::malloc(size == 0 ? 1 : size)) return pointer;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    std::free(pointer);
+}
+#endif
+
+struct BenchConfig {
+    int actor_count = 1000000;
+    int max_thread_count = 0;
+    int repeat_count = 5;
+
+    // Which suites to run: micro, negotiate and round
+    vector<std::string> suites{"micro", "negotiate", "round"};
+
+    // Populations the round suite plays, and how many rounds of each
+    vector<int> round_sizes{100, 10000, 1000000, 10000000};
+    int round_count = 20;
+
+    [[nodiscard]] bool runs(const char* suite) const {
+        return std::find(suites.begin(), suites.end(), suite) != suites.end();
+    }
+};
+
+// A population one round into the game, so that hands differ and negotiation has work to do
+struct Population {
+    ActorRegistry actors;
+    HandleList negotiate_list;
+};
+
+static Population make_population(int actor_count) {
+    generator.seed(1);
+
+    Population population{init_actors(actor_count, {}), {}};
+    Global global(population.actors);
+
+    auto list = compete_list(compete_candidates(global));
+    auto_compete(global, list);
+    remove_actors(global);
+
+    population.negotiate_list = negotiate_list(negotiate_candidates(global, list));
+    return population;
+}
+
+// Keeps the results of benchmarked calls alive
+static volatile float sink;
+
+// The best time of repeated runs of a benchmark, with the heap allocations of that run
+struct Measurement {
+    double seconds = 0;
+    long long allocations = 0;
+};
+
+// Time run repeat_count times, calling prepare untimed before each
+template<typename Prepare, typename Run>
+static Measurement measure(int repeat_count, Prepare prepare, Run run) {
+    Measurement best;
+    for (int repeat = 0; repeat < repeat_count; ++repeat) {
+        prepare();
+
+        long long heap_before = heap_allocations();
+        auto start = std::chrono::steady_clock::now();
+        run();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        long long allocations = heap_allocations() - heap_before;
+
+        if (repeat == 0 || elapsed.count() < best.seconds) best = Measurement{elapsed.count(), allocations};
+    }
+    return best;
+}
+
+static void report_micro(const char* name, const BenchConfig& config, size_t item_count,
+                         const Measurement& measurement) {
+    cout << name << '\t' << config.actor_count << '\t' << item_count << '\t'
+         << (item_count > 0 ? measurement.seconds * 1e9 / (double) item_count : 0) << '\t'
+         << measurement.allocations << endl;
+}
+
+// The single phases on the population; items are actors, or the actors in the list a phase works on.
+// Phases that change the game run on a fresh copy of the population each time.
+static void bench_micro(const BenchConfig& config) {
+    auto population = make_population(config.actor_count);
+    RoundArena arena;
+
+    ActorRegistry actors;
+    std::optional<Global> global;
+    auto fresh = [&]() {
+        global.reset();
+        actors = population.actors;
+        global.emplace(actors);
+    };
+    auto forget_predictions = [&]() {
+        for (auto& actor : actors)
+            actor.prediction.valid = false;
+    };
+    auto nothing = []() {};
+
+    // Every actor that can compete, so that the compete phases see the whole population
+    HandleList list;
+    auto make_full_list = [&]() {
+        list = compete_top(*global, (size_t) global->eligible_count & ~(size_t) 1);
+        std::shuffle(list.begin(), list.end(), generator);
+    };
+
+    cout << "benchmark\tactors\titems\tns_per_item\tallocations_per_run" << endl;
+    fresh();
+
+    auto measurement = measure(config.repeat_count, nothing, [&]() {
+        float sum = 0;
+        for (auto& actor : actors)
+            sum += competitor_prob(*global, actor)[Card::STONE];
+        sink = sum;
+    });
+    report_micro("competitor_prob", config, actors.size(), measurement);
+
+    measurement = measure(config.repeat_count, forget_predictions, [&]() {
+        float sum = 0;
+        for (auto& actor : actors)
+            sum += actor_compete_will(*global, actor);
+        sink = sum;
+    });
+    report_micro("actor_compete_will", config, actors.size(), measurement);
+
+    // The same wills from the column store, one actor at a time and then several per instruction
+    ActorStore store(actors);
+    vector<float> wills(store.size());
+    measurement = measure(config.repeat_count, nothing, [&]() {
+        compute_compete_wills_scalar(*global, store, wills.data());
+        sink = wills.empty() ? 0 : wills.back();
+    });
+    report_micro("compute_compete_wills_scalar", config, store.size(), measurement);
+
+    measurement = measure(config.repeat_count, nothing, [&]() {
+        compute_compete_wills(*global, store, wills.data());
+        sink = wills.empty() ? 0 : wills.back();
+    });
+    report_micro("compute_compete_wills", config, store.size(), measurement);
+
+    measurement = measure(config.repeat_count, forget_predictions, [&]() {
+        RoundScope round_scope(arena);
+        sink = (float) compete_candidates(*global).size();
+    });
+    report_micro("compete_candidates", config, actors.size(), measurement);
+
+    measurement = measure(config.repeat_count, forget_predictions, [&]() {
+        RoundScope round_scope(arena);
+        sink = (float) compete_top(*global, actors.size()).size();
+    });
+    report_micro("compete_top", config, actors.size(), measurement);
+
+    measurement = measure(config.repeat_count, [&]() {
+        fresh();
+        make_full_list();
+    }, [&]() {
+        RoundScope round_scope(arena);
+        auto_compete(*global, list);
+    });
+    report_micro("auto_compete", config, list.size(), measurement);
+
+    measurement = measure(config.repeat_count, [&]() {
+        fresh();
+        make_full_list();
+        auto_compete(*global, list);
+    }, [&]() {
+        RoundScope round_scope(arena);
+        remove_actors(*global);
+    });
+    report_micro("remove_actors", config, population.actors.size(), measurement);
+
+    measurement = measure(config.repeat_count, fresh, [&]() {
+        RoundScope round_scope(arena);
+        sink = (float) negotiate_candidates(*global, list).size();
+    });
+    report_micro("negotiate_candidates", config, actors.size(), measurement);
+
+    measurement = measure(config.repeat_count, fresh, [&]() {
+        RoundScope round_scope(arena);
+        auto_negotiate(*global, population.negotiate_list);
+    });
+    report_micro("auto_negotiate", config, population.negotiate_list.size(), measurement);
+}
+
+static bool same_hands(const ActorRegistry& a, const ActorRegistry& b) {
+    if (a.size() != b.size()) return false;
+    for (auto i = a.begin(), j = b.begin(); i != a.end(); ++i, ++j)
+        if (i->stone_count != j->stone_count || i->scissor_count != j->scissor_count ||
+            i->paper_count != j->paper_count || i->star_count != j->star_count)
+            return false;
+    return true;
+}
+
+// Best of `repeat_count` runs of auto_negotiate over fresh copies of the population, in seconds
+template<typename Negotiate>
+static double time_negotiate(const Population& population, int repeat_count, Negotiate negotiate,
+                             ActorRegistry& result) {
+    double best = 0;
+    for (int repeat = 0; repeat < repeat_count; ++repeat) {
+        result = population.actors;
+        Global global(result);
+
+        auto start = std::chrono::steady_clock::now();
+        negotiate(global, population.negotiate_list);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        if (repeat == 0 || elapsed.count() < best) best = elapsed.count();
+    }
+    return best;
+}
+
+static void bench_negotiate_scaling(const BenchConfig& config) {
+    auto population = make_population(config.actor_count);
+    size_t pair_count = population.negotiate_list.size() / 2;
+
+    ActorRegistry serial_result;
+    double serial = time_negotiate(population, config.repeat_count, [](Global& global, auto& list) {
+        auto_negotiate(global, list);
+    }, serial_result);
+
+    cout << "benchmark\tthreads\tpairs\tns_per_pair\tspeedup\tidentical" << endl;
+    cout << "auto_negotiate\t1\t" << pair_count << '\t' << serial * 1e9 / pair_count << "\t1\t1" << endl;
+
+    // Powers of two, then the full thread count
+    vector<int> thread_counts;
+    for (int thread_count = 1; thread_count < config.max_thread_count; thread_count *= 2)
+        thread_counts.push_back(thread_count);
+    thread_counts.push_back(config.max_thread_count);
+
+    for (int thread_count : thread_counts) {
+        ThreadPool pool(thread_count);
+        ActorRegistry result;
+        double parallel = time_negotiate(population, config.repeat_count, [&](Global& global, auto& list) {
+            auto_negotiate_parallel(global, list, pool);
+        }, result);
+
+        cout << "auto_negotiate_parallel\t" << thread_count << '\t' << pair_count << '\t'
+             << parallel * 1e9 / pair_count << '\t' << serial / parallel << '\t'
+             << same_hands(serial_result, result) << endl;
+    }
+}
+
+// Play rounds of fresh games of each size and report the time per actor and round, and the heap allocations
+// per round. Steady-state rounds are those after the warm-up, once the round arena has grown to fit; the
+// round lists should then no longer reach the heap at all, and what is left is Global's hand buckets growing
+// past any spare buffer as hands change.
+static void bench_rounds(const BenchConfig& config) {
+    constexpr int warmup_rounds = 3;
+
+    cout << "benchmark\tactors\trounds\tns_per_actor_round\theap_allocations_per_round"
+         << "\tsteady_heap_allocations_per_round\tsteady_list_heap_allocations_per_round"
+         << "\tarena_allocations_per_round\tarena_bytes" << endl;
+
+    for (int actor_count : config.round_sizes) {
+        generator.seed(1);
+        auto actors = init_actors(actor_count, {});
+        Global global(actors);
+        RoundArena arena;
+
+        double seconds = 0;
+        long long actor_rounds = 0;
+        long long heap = 0;
+        long long steady_heap = 0;
+        long long steady_overflows = 0;
+        int steady_rounds = 0;
+        int played_rounds = 0;
+        for (; played_rounds < config.round_count && !actors.empty(); ++played_rounds) {
+            actor_rounds += (long long) actors.size();
+            long long heap_before = heap_allocations();
+            long long overflows_before = arena.heap_counters().allocations;
+            auto start = std::chrono::steady_clock::now();
+            {
+                RoundScope round_scope(arena);
+                auto list = compete_list(global);
+                auto_compete(global, list);
+                remove_actors(global);
+                auto candidates = negotiate_candidates(global, list);
+                list = negotiate_list(candidates);
+                auto_negotiate(global, list);
+                finish_round(global);
+            }
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            seconds += elapsed.count();
+            heap += heap_allocations() - heap_before;
+            if (played_rounds >= warmup_rounds) {
+                steady_heap += heap_allocations() - heap_before;
+                steady_overflows += arena.heap_counters().allocations - overflows_before;
+                ++steady_rounds;
+            }
+        }
+
+        double per_round = played_rounds > 0 ? 1.0 / played_rounds : 0;
+        double per_steady_round = steady_rounds > 0 ? 1.0 / steady_rounds : 0;
+        cout << "round\t" << actor_count << '\t' << played_rounds << '\t'
+             << (actor_rounds > 0 ? seconds * 1e9 / (double) actor_rounds : 0) << '\t'
+             << (double) heap * per_round << '\t' << (double) steady_heap * per_steady_round << '\t'
+             << (double) steady_overflows * per_steady_round << '\t'
+             << (double) arena.served_counters().allocations * per_round << '\t' << arena.capacity() << endl;
+    }
+}
+
+static void bench_usage() {
+    cerr << "Usage: animal_world_bench [--actors N] [--threads N] [--repeats N] [--suites micro,negotiate,round]"
+         << " [--round-sizes N,N,...] [--rounds N]" << endl;
+}
+
+static vector<std::string> split_list(const char* value) {
+    vector<std::string> items;
+    std::stringstream stream{value};
+    std::string item;
+    while (std::getline(stream, item, ','))
+        if (!item.empty()) items.push_back(item);
+    return items;
+}
+
+int main(int argc, char** argv) {
+    BenchConfig config;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (value == nullptr) {
+            bench_usage();
+            return 1;
+        }
+
+        if (strcmp(arg, "--actors") == 0) config.actor_count = std::stoi(value);
+        else if (strcmp(arg, "--threads") == 0) config.max_thread_count = std::stoi(value);
+        else if (strcmp(arg, "--repeats") == 0) config.repeat_count = std::stoi(value);
+        else if (strcmp(arg, "--suites") == 0) config.suites = split_list(value);
+        else if (strcmp(arg, "--rounds") == 0) config.round_count = std::stoi(value);
+        else if (strcmp(arg, "--round-sizes") == 0) {
+            config.round_sizes.clear();
+            for (auto& item : split_list(value))
+                config.round_sizes.push_back(std::stoi(item));
+        } else {
+            bench_usage();
+            return 1;
+        }
+        ++i;
+    }
+
+    if (config.max_thread_count <= 0)
+        config.max_thread_count = (int) std::max(1u, std::thread::hardware_concurrency());
+    if (config.actor_count <= 0 || config.repeat_count <= 0) {
+        bench_usage();
+        return 1;
+    }
+
+    // Suites print one table each, a header line and then one tab-separated row per benchmark
+    bool first = true;
+    auto run = [&](const char* suite, void (*bench)(const BenchConfig&)) {
+        if (!config.runs(suite)) return;
+        if (!first) cout << endl;
+        first = false;
+        bench(config);
+    };
+    run("micro", bench_micro);
+    run("negotiate", bench_negotiate_scaling);
+    run("round", bench_rounds);
+    return 0;
+}
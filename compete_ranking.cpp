@@ -0,0 +1,83 @@
+#include "compete_ranking.h"
+#include "actor_store.h"
+#include "game_phases.h"
+#include "round_arena.h"
+
+#include <algorithm>
+
+HandleList compete_top(Global& global, size_t count) {
+    PROFILE_PHASE(Phase::CANDIDATES);
+    global.refresh();
+    auto& buckets = global.hand_buckets;
+
+    // One hand per non-empty bucket, whose wills are worked out together by the vectorized kernel. Hands too
+    // large for its byte-wide columns take the scalar path instead.
+    ActorStore hands(round_resource());
+    std::pmr::vector<uint32_t> hand_buckets(round_resource());
+    std::pmr::vector<std::pair<float, uint32_t>> ranked(round_resource());
+    hands.reserve(buckets.size());
+    hand_buckets.reserve(buckets.size());
+    ranked.reserve(buckets.size());
+    for (uint32_t i = 0; i < buckets.size(); ++i) {
+        if (buckets[i].members.empty()) continue;
+        auto& actor = global.actors[buckets[i].members.front()];
+        if (ActorStore::fits(actor)) {
+            hands.push_back(actor);
+            hand_buckets.push_back(i);
+        } else {
+            ranked.emplace_back(actor_compete_will(global, actor), i);
+        }
+    }
+
+    std::pmr::vector<float> wills(hands.size(), round_resource());
+    compute_compete_wills(global, hands, wills.data());
+    for (size_t i = 0; i < hands.size(); ++i)
+        ranked.emplace_back(wills[i], hand_buckets[i]);
+    std::sort(ranked.begin(), ranked.end(), [](auto& b1, auto& b2) { return b1.first > b2.first; });
+
+    HandleList list(round_resource());
+    list.reserve(count);
+
+    for (size_t i = 0; i < ranked.size() && list.size() < count;) {
+        // Tuples of equal will form one level
+        size_t level_end = i;
+        size_t level_size = 0;
+        for (; level_end < ranked.size() && ranked[level_end].first == ranked[i].first; ++level_end)
+            level_size += buckets[ranked[level_end].second].members.size();
+
+        size_t wanted = count - list.size();
+        size_t begin = list.size();
+        for (size_t j = i; j < level_end; ++j) {
+            auto& members = buckets[ranked[j].second].members;
+            list.insert(list.end(), members.begin(), members.end());
+        }
+
+        if (level_size > wanted) {
+            // The cut falls inside this level, where any actor is as good as another. Shuffle whichever
+            // side of the cut is smaller into place, then drop the rest.
+            auto tied = list.begin() + (std::ptrdiff_t) begin;
+            if (wanted <= level_size - wanted) {
+                for (size_t j = 0; j < wanted; ++j) {
+                    auto dist = std::uniform_int_distribution<size_t>(j, level_size - 1);
+                    std::swap(tied[j], tied[dist(generator)]);
+                }
+            } else {
+                for (size_t j = level_size - 1; j >= wanted; --j) {
+                    auto dist = std::uniform_int_distribution<size_t>(0, j);
+                    std::swap(tied[j], tied[dist(generator)]);
+                }
+            }
+            list.resize(begin + wanted);
+        }
+        i = level_end;
+    }
+    return list;
+}
+
+HandleList compete_list(Global& global) {
+    return compete_list(global, DefaultStrategy{});
+}
+
+// The strategies built into the library, see game_phases.h
+template HandleList compete_list(Global&, const DefaultStrategy&);
+template HandleList compete_list(Global&, const Tournament&);
@@ -0,0 +1,20 @@
+#ifndef ANIMAL_WORLD_COMPETE_RANKING_H
+#define ANIMAL_WORLD_COMPETE_RANKING_H
+
+#include "game.h"
+
+#include <vector>
+
+// The will to compete depends only on the hand and the global counts, so the ranking works on the hand
+// buckets that Global keeps: one will per tuple, and the top is given out by walking tuples in order of
+// will instead of sorting the actors.
+
+// The count actors with the highest will, in no particular order. Actors tied at the cut are chosen
+// at random with the thread's generator. O(t log t) in the number of tuples t, to rank their wills, plus
+// O(count) and the size of the tied group at the cut.
+HandleList compete_top(Global& global, size_t count);
+
+// Draw the compete list from the ranking: a random even-sized prefix of it, shuffled
+HandleList compete_list(Global& global);
+
+#endif //ANIMAL_WORLD_COMPETE_RANKING_H
@@ -0,0 +1,171 @@
+#include "event_trace.h"
+
+#include <chrono>
+#include <cstring>
+
+using std::vector;
+using std::string;
+
+// Layout of a trace: this header, then blocks. A block is its event count n followed by the columns of its
+// events in the order of the Event fields, n values each, so that every column compresses and scans well.
+struct EventTraceHeader {
+    char magic[4];
+    uint32_t version;
+};
+
+static const char event_trace_magic[4] = {'A', 'W', 'E', 'T'};
+static const uint32_t event_trace_version = 1;
+
+static constexpr size_t events_per_block = 1 << 16;
+
+// The size of one event across all columns
+static constexpr size_t event_size = sizeof(Event::game) + sizeof(Event::round) + sizeof(Event::type) +
+                                     sizeof(Event::card) + sizeof(Event::other_card) + sizeof(Event::value) +
+                                     sizeof(Event::actor) + sizeof(Event::other);
+
+thread_local EventChannel* current_trace_channel = nullptr;
+
+const char* event_name(EventType type) {
+    switch (type) {
+        case EventType::MATCH_PLAYED:
+            return "match_played";
+        case EventType::CARD_CONSUMED:
+            return "card_consumed";
+        case EventType::STAR_TRANSFERRED:
+            return "star_transferred";
+        case EventType::CARD_GIVEN:
+            return "card_given";
+        case EventType::ACTOR_SAFE:
+            return "actor_safe";
+        case EventType::ACTOR_ELIMINATED:
+            return "actor_eliminated";
+    }
+    return "unknown";
+}
+
+void EventChannel::record(EventType type, int32_t actor, int32_t other, uint8_t card, uint8_t other_card,
+                          int8_t value) {
+    Event event{game, round, type, card, other_card, value, actor, other};
+
+    // The writer is a whole ring behind; wait for it rather than lose events
+    while (!ring.try_push(event))
+        std::this_thread::yield();
+}
+
+EventChannel* worker_trace_channel(EventChannel* caller, int worker) {
+    if (caller == nullptr || worker >= caller->owner().channel_count()) return nullptr;
+
+    auto& channel = caller->owner().channel(worker);
+    channel.set_context(caller->current_game(), caller->current_round());
+    return &channel;
+}
+
+EventTrace::EventTrace(const string& filename, int channel_count, size_t channel_capacity)
+        : fs{filename, std::ios::binary}, block(events_per_block) {
+    for (int i = 0; i < channel_count; ++i)
+        channels.push_back(std::make_unique<EventChannel>(*this, channel_capacity));
+
+    EventTraceHeader header{};
+    memcpy(header.magic, event_trace_magic, sizeof(header.magic));
+    header.version = event_trace_version;
+    fs.write((const char*) &header, sizeof(header));
+    opened = (bool) fs;
+
+    writer = std::thread([this] { run(); });
+}
+
+EventTrace::~EventTrace() {
+    stopping.store(true, std::memory_order_release);
+    writer.join();
+}
+
+void EventTrace::run() {
+    while (true) {
+        // Read the flag first, so that the last pass sees everything recorded before it was set
+        bool stop = stopping.load(std::memory_order_acquire);
+        if (!collect()) {
+            if (stop) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    flush();
+}
+
+bool EventTrace::collect() {
+    bool any = false;
+    for (auto& channel : channels) {
+        size_t count;
+        while ((count = channel->ring.pop(block.data() + block_count, block.size() - block_count)) > 0) {
+            any = true;
+            block_count += count;
+            if (block_count == block.size()) flush();
+        }
+    }
+    return any;
+}
+
+template<typename Field>
+static void write_column(std::ofstream& fs, const vector<Event>& block, size_t count, Field Event::* field,
+                         vector<char>& column) {
+    column.resize(count * sizeof(Field));
+    for (size_t i = 0; i < count; ++i)
+        memcpy(column.data() + i * sizeof(Field), &(block[i].*field), sizeof(Field));
+    fs.write(column.data(), (std::streamsize) column.size());
+}
+
+void EventTrace::flush() {
+    if (block_count == 0) return;
+
+    auto count = (uint32_t) block_count;
+    fs.write((const char*) &count, sizeof(count));
+
+    vector<char> column;
+    write_column(fs, block, block_count, &Event::game, column);
+    write_column(fs, block, block_count, &Event::round, column);
+    write_column(fs, block, block_count, &Event::type, column);
+    write_column(fs, block, block_count, &Event::card, column);
+    write_column(fs, block, block_count, &Event::other_card, column);
+    write_column(fs, block, block_count, &Event::value, column);
+    write_column(fs, block, block_count, &Event::actor, column);
+    write_column(fs, block, block_count, &Event::other, column);
+
+    written.fetch_add((long long) block_count, std::memory_order_relaxed);
+    block_count = 0;
+}
+
+EventTraceReader::EventTraceReader(const string& filename) : file{filename} {
+    if (!file.is_open() || file.size() < sizeof(EventTraceHeader)) return;
+
+    EventTraceHeader header{};
+    memcpy(&header, file.data(), sizeof(header));
+    valid = memcmp(header.magic, event_trace_magic, sizeof(header.magic)) == 0 &&
+            header.version == event_trace_version;
+    offset = sizeof(header);
+}
+
+template<typename Field>
+static const char* read_column(const char* column, vector<Event>& events, Field Event::* field) {
+    for (size_t i = 0; i < events.size(); ++i)
+        memcpy(&(events[i].*field), column + i * sizeof(Field), sizeof(Field));
+    return column + events.size() * sizeof(Field);
+}
+
+bool EventTraceReader::next(vector<Event>& events) {
+    uint32_t count;
+    if (!valid || file.size() - offset < sizeof(count)) return false;
+    memcpy(&count, file.data() + offset, sizeof(count));
+    if ((file.size() - offset - sizeof(count)) / event_size < count) return false;
+
+    events.resize(count);
+    const char* column = file.data() + offset + sizeof(count);
+    column = read_column(column, events, &Event::game);
+    column = read_column(column, events, &Event::round);
+    column = read_column(column, events, &Event::type);
+    column = read_column(column, events, &Event::card);
+    column = read_column(column, events, &Event::other_card);
+    column = read_column(column, events, &Event::value);
+    column = read_column(column, events, &Event::actor);
+    column = read_column(column, events, &Event::other);
+    offset = column - file.data();
+    return true;
+}
@@ -0,0 +1,175 @@
+#ifndef ANIMAL_WORLD_EVENT_TRACE_H
+#define ANIMAL_WORLD_EVENT_TRACE_H
+
+#include "spsc_ring.h"
+#include "mapped_file.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <fstream>
+#include <cstdint>
+
+// A trace of everything that happens to actors, written to disk by a background thread.
+//
+// Each thread that plays records into a channel of its own, an SPSC ring that the writer drains, so
+// recording an event is a store into the ring and never waits on the disk. Only when the writer falls a
+// whole ring behind does a producer wait for room, since traces are meant to be complete.
+//
+// The file is a header followed by blocks of events stored column by column, see event_trace.cpp.
+
+enum class EventType : uint8_t {
+    // actor played card against other, who played other_card; value is +1, 0 or -1 for the actor
+    MATCH_PLAYED,
+    // actor used up card
+    CARD_CONSUMED,
+    // actor won value stars from other
+    STAR_TRANSFERRED,
+    // actor gave card to other
+    CARD_GIVEN,
+    ACTOR_SAFE,
+    ACTOR_ELIMINATED,
+};
+
+// Actors are named by Actor::id; other is -1 and cards are 0xff where an event has none
+struct Event {
+    uint32_t game;
+    uint16_t round;
+    EventType type;
+    uint8_t card;
+    uint8_t other_card;
+    int8_t value;
+    int32_t actor;
+    int32_t other;
+};
+
+static constexpr uint8_t no_card = 0xff;
+
+const char* event_name(EventType type);
+
+class EventTrace;
+
+// Where one thread records its events
+class EventChannel {
+public:
+    EventChannel(EventTrace& trace, size_t capacity) : trace{trace}, ring{capacity} {}
+
+    // The game and round that the events recorded from now on belong to
+    void set_context(uint32_t game, uint32_t round) {
+        this->game = game;
+        this->round = (uint16_t) round;
+    }
+
+    void record(EventType type, int32_t actor, int32_t other, uint8_t card, uint8_t other_card, int8_t value);
+
+    [[nodiscard]] EventTrace& owner() const { return trace; }
+
+    [[nodiscard]] uint32_t current_game() const { return game; }
+
+    [[nodiscard]] uint32_t current_round() const { return round; }
+
+private:
+    friend class EventTrace;
+
+    EventTrace& trace;
+    SpscRing<Event> ring;
+    uint32_t game = 0;
+    uint16_t round = 0;
+};
+
+class EventTrace {
+public:
+    // One channel per thread that records; writing starts at once
+    EventTrace(const std::string& filename, int channel_count, size_t channel_capacity = 1 << 16);
+
+    // Writes out whatever the channels still hold
+    ~EventTrace();
+
+    EventTrace(const EventTrace&) = delete;
+
+    EventTrace& operator=(const EventTrace&) = delete;
+
+    [[nodiscard]] bool is_open() const { return opened; }
+
+    [[nodiscard]] int channel_count() const { return (int) channels.size(); }
+
+    EventChannel& channel(int index) { return *channels[index]; }
+
+    // Events written so far
+    [[nodiscard]] long long written_count() const { return written.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+
+    // Drain every channel into the block; returns whether anything was there
+    bool collect();
+
+    void flush();
+
+    std::ofstream fs;
+    bool opened = false;
+    std::vector<std::unique_ptr<EventChannel>> channels;
+
+    // The block being filled, as one array of events; it is split into columns as it is written
+    std::vector<Event> block;
+    size_t block_count = 0;
+
+    std::atomic<bool> stopping{false};
+    std::atomic<long long> written{0};
+    std::thread writer;
+};
+
+// The channel of the calling thread, or null while no TraceScope is active on it
+extern thread_local EventChannel* current_trace_channel;
+
+inline EventChannel* trace_channel() {
+    return current_trace_channel;
+}
+
+inline void trace_event(EventType type, int32_t actor, int32_t other = -1, uint8_t card = no_card,
+                        uint8_t other_card = no_card, int8_t value = 0) {
+    if (current_trace_channel != nullptr)
+        current_trace_channel->record(type, actor, other, card, other_card, value);
+}
+
+// The channel a pool worker records into while it helps with the phase of a game traced into caller.
+// Worker w of a pool records into channel w, so callers that split phases trace into channel 0.
+EventChannel* worker_trace_channel(EventChannel* caller, int worker);
+
+// Makes a channel the one the calling thread records into while it lives; null turns tracing off
+class TraceScope {
+public:
+    explicit TraceScope(EventChannel* channel) : previous{current_trace_channel} {
+        current_trace_channel = channel;
+    }
+
+    ~TraceScope() { current_trace_channel = previous; }
+
+    TraceScope(const TraceScope&) = delete;
+
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    EventChannel* previous;
+};
+
+// Reads a trace back one block at a time, so traces larger than memory can be read
+class EventTraceReader {
+public:
+    explicit EventTraceReader(const std::string& filename);
+
+    // Whether the file is a trace
+    [[nodiscard]] bool is_open() const { return valid; }
+
+    // Replace events with the next block; false at the end of the trace or at a damaged block
+    bool next(std::vector<Event>& events);
+
+private:
+    MappedFile file;
+    bool valid = false;
+    size_t offset = 0;
+};
+
+#endif //ANIMAL_WORLD_EVENT_TRACE_H
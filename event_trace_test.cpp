@@ -0,0 +1,128 @@
+#include "event_trace.h"
+
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <cstdio>
+
+using std::cerr;
+using std::endl;
+using std::vector;
+
+// The i-th event recorded into channel, with every field depending on both
+static Event expected_event(int channel, int i) {
+    Event event{};
+    event.game = (uint32_t) channel;
+    event.round = (uint16_t) (i / 1000);
+    event.type = (EventType) (i % 6);
+    event.card = i % 4 == 3 ? no_card : (uint8_t) (i % 4);
+    event.other_card = (uint8_t) ((i + channel) % 3);
+    event.value = (int8_t) (i % 3 - 1);
+    event.actor = i;
+    event.other = i % 5 == 0 ? -1 : channel * 100000 + i;
+    return event;
+}
+
+static bool same_event(const Event& e1, const Event& e2) {
+    return e1.game == e2.game && e1.round == e2.round && e1.type == e2.type && e1.card == e2.card &&
+           e1.other_card == e2.other_card && e1.value == e2.value && e1.actor == e2.actor && e1.other == e2.other;
+}
+
+// Every event of a trace up to its end or its first damaged block, and the number of blocks read
+static vector<Event> read_trace(const char* filename, size_t& block_count) {
+    EventTraceReader reader(filename);
+    vector<Event> events;
+    vector<Event> block;
+    block_count = 0;
+    while (reader.next(block)) {
+        events.insert(events.end(), block.begin(), block.end());
+        ++block_count;
+    }
+    return events;
+}
+
+// Events recorded from several threads come back from the file in each channel's order with every field intact,
+// and a trace cut off inside its last block reads as the blocks before it
+int main() {
+    const char* trace_file = "event_trace_test.trace";
+    const char* truncated_file = "event_trace_test_truncated.trace";
+    const int channel_count = 3;
+    // Far more than a ring holds, so producers keep running into a full ring and wait for the writer, and more
+    // than a block holds, so the trace spans several blocks
+    const int events_per_channel = 40000;
+    const size_t ring_capacity = 64;
+
+    {
+        EventTrace trace(trace_file, channel_count, ring_capacity);
+        if (!trace.is_open()) {
+            cerr << "cannot write " << trace_file << endl;
+            return 1;
+        }
+
+        vector<std::thread> producers;
+        for (int c = 0; c < channel_count; ++c)
+            producers.emplace_back([&trace, c] {
+                auto& channel = trace.channel(c);
+                for (int i = 0; i < events_per_channel; ++i) {
+                    Event event = expected_event(c, i);
+                    channel.set_context(event.game, event.round);
+                    channel.record(event.type, event.actor, event.other, event.card, event.other_card, event.value);
+                }
+            });
+        for (auto& producer : producers)
+            producer.join();
+    }
+
+    int failures = 0;
+    size_t block_count;
+    auto events = read_trace(trace_file, block_count);
+    if (events.size() != (size_t) channel_count * events_per_channel) {
+        cerr << "read " << events.size() << " events, recorded " << channel_count * events_per_channel << endl;
+        ++failures;
+    }
+    if (block_count < 2) {
+        cerr << "the trace was written in " << block_count << " blocks, expected several" << endl;
+        ++failures;
+    }
+
+    // Channels interleave in the file, but each keeps its own order
+    vector<int> next(channel_count, 0);
+    for (auto& event : events) {
+        if (event.game >= (uint32_t) channel_count) {
+            cerr << "event of unknown channel " << event.game << endl;
+            ++failures;
+            break;
+        }
+        int c = (int) event.game;
+        if (next[c] >= events_per_channel || !same_event(event, expected_event(c, next[c]))) {
+            cerr << "event " << next[c] << " of channel " << c << " differs" << endl;
+            ++failures;
+            break;
+        }
+        ++next[c];
+    }
+
+    // Cut the last block short: the reader stops after the complete blocks rather than read past the end
+    std::ifstream in{trace_file, std::ios::binary};
+    vector<char> bytes{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    in.close();
+    {
+        std::ofstream out{truncated_file, std::ios::binary};
+        out.write(bytes.data(), (std::streamsize) (bytes.size() - 7));
+    }
+    size_t truncated_block_count;
+    auto truncated_events = read_trace(truncated_file, truncated_block_count);
+    if (truncated_block_count != block_count - 1 || truncated_events.size() >= events.size() ||
+        !std::equal(truncated_events.begin(), truncated_events.end(), events.begin(), same_event)) {
+        cerr << "a truncated trace read as " << truncated_block_count << " blocks of " << truncated_events.size()
+             << " events" << endl;
+        ++failures;
+    }
+
+    std::remove(trace_file);
+    std::remove(truncated_file);
+    return failures == 0 ? 0 : 1;
+}
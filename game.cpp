@@ -0,0 +1,1029 @@
+#include "game.h"
+#include "philox.h"
+#include "thread_pool.h"
+#include "round_arena.h"
+#include "event_trace.h"
+#include "render.h"
+#include "lookahead.h"
+#include "game_phases.h"
+
+#include <iostream>
+#include <algorithm>
+#include <numeric>
+#include <cassert>
+#include <utility>
+
+using std::cout;
+using std::cerr;
+using std::endl;
+using std::vector;
+using std::string;
+
+thread_local GameEngine generator;
+
+string verbose(Card card) {
+    switch (card) {
+        case Card::STONE:
+            return "stone";
+        case Card::SCISSOR:
+            return "scissor";
+        case Card::PAPER:
+            return "paper";
+    }
+}
+
+int Actor::card_count(Card card) const {
+    switch (card) {
+        case Card::STONE:
+            return stone_count;
+        case Card::SCISSOR:
+            return scissor_count;
+        case Card::PAPER:
+            return paper_count;
+    }
+}
+
+void Actor::add_card(Card card) {
+    prediction.valid = false;
+    switch (card) {
+        case Card::STONE:
+            ++stone_count;
+            break;
+        case Card::SCISSOR:
+            ++scissor_count;
+            break;
+        case Card::PAPER:
+            ++paper_count;
+            break;
+    }
+}
+
+void Actor::remove_card(Card card) {
+    prediction.valid = false;
+    switch (card) {
+        case Card::STONE:
+            --stone_count;
+            break;
+        case Card::SCISSOR:
+            --scissor_count;
+            break;
+        case Card::PAPER:
+            --paper_count;
+            break;
+    }
+}
+
+ActorHandle ActorRegistry::add(const Actor& actor) {
+    uint32_t slot;
+    if (free_slots.empty()) {
+        slot = (uint32_t) slots.size();
+        slots.push_back(Slot{0, 0});
+    } else {
+        slot = free_slots.back();
+        free_slots.pop_back();
+    }
+
+    slots[slot].position = (uint32_t) actors.size();
+    actors.push_back(actor);
+    positions_slot.push_back(slot);
+    removed.push_back(false);
+
+    return ActorHandle{slot, slots[slot].generation};
+}
+
+void ActorRegistry::reserve(size_t count) {
+    actors.reserve(count);
+    positions_slot.reserve(count);
+    removed.reserve(count);
+    slots.reserve(count);
+}
+
+bool ActorRegistry::contains(ActorHandle handle) const {
+    if (handle.slot >= slots.size()) return false;
+
+    auto& slot = slots[handle.slot];
+    return slot.generation == handle.generation && !removed[slot.position];
+}
+
+Actor& ActorRegistry::operator[](ActorHandle handle) {
+    assert(handle.slot < slots.size() && slots[handle.slot].generation == handle.generation);
+    return actors[slots[handle.slot].position];
+}
+
+const Actor& ActorRegistry::operator[](ActorHandle handle) const {
+    assert(handle.slot < slots.size() && slots[handle.slot].generation == handle.generation);
+    return actors[slots[handle.slot].position];
+}
+
+ActorHandle ActorRegistry::handle(const Actor& actor) const {
+    auto position = (size_t) (&actor - actors.data());
+    assert(position < actors.size());
+
+    uint32_t slot = positions_slot[position];
+    return ActorHandle{slot, slots[slot].generation};
+}
+
+void ActorRegistry::remove(ActorHandle handle) {
+    assert(contains(handle));
+    removed[slots[handle.slot].position] = true;
+    ++removed_count;
+}
+
+void ActorRegistry::compact() {
+    if (removed_count == 0) return;
+    // Every slot may end up free, so this only grows while the registry does
+    free_slots.reserve(slots.size());
+
+    size_t kept = 0;
+    for (size_t position = 0; position < actors.size(); ++position) {
+        uint32_t slot = positions_slot[position];
+
+        if (removed[position]) {
+            // Outstanding handles to this actor become stale
+            ++slots[slot].generation;
+            free_slots.push_back(slot);
+            continue;
+        }
+
+        if (kept != position) {
+            actors[kept] = std::move(actors[position]);
+            positions_slot[kept] = slot;
+        }
+        slots[slot].position = (uint32_t) kept;
+        ++kept;
+    }
+
+    actors.resize(kept);
+    positions_slot.resize(kept);
+    removed.assign(kept, false);
+    removed_count = 0;
+}
+
+Global::Global(ActorRegistry& actors, const Rules& rules) : actors{actors}, rules{rules} {
+    // Each actor is safe or eliminated at most once, so the sets never need to grow during the game
+    safe_actors.reserve(actors.size());
+    eliminated_actors.reserve(actors.size());
+    for (auto& actor : actors) {
+        stone_count += actor.stone_count;
+        scissor_count += actor.scissor_count;
+        paper_count += actor.paper_count;
+        file(actors.handle(actor), actor);
+    }
+}
+
+Global::Global(ActorRegistry& actors, const CardCounts& counts, const std::vector<HandBucket>& buckets,
+               const Rules& rules)
+        : CardCounts{counts}, actors{actors}, rules{rules} {
+    safe_actors.reserve(actors.size());
+    eliminated_actors.reserve(actors.size());
+    for (auto& bucket : buckets) {
+        Actor hand{};
+        hand.stone_count = (int) (bucket.key & 0x3ff);
+        hand.scissor_count = (int) (bucket.key >> 10 & 0x3ff);
+        hand.paper_count = (int) (bucket.key >> 20 & 0x3ff);
+        bucket_of(hand);
+        for (auto handle : bucket.members)
+            file(handle, actors[handle]);
+    }
+
+    // Filing again is a no-op for the members, and files the actors that cannot compete
+    for (auto& actor : actors)
+        file(actors.handle(actor), actor);
+}
+
+Global::Global(ActorRegistry& actors, const Global& other) : actors{actors} {
+    assign(other);
+    safe_actors.reserve(actors.size());
+    eliminated_actors.reserve(actors.size());
+}
+
+void Global::take(Global&& other) {
+    assign(std::move(other));
+}
+
+template<typename Other>
+void Global::assign(Other&& other) {
+    static_cast<CardCounts&>(*this) = other;
+    rules = other.rules;
+    round = other.round;
+    seed = other.seed;
+    lookahead = other.lookahead;
+    hand_buckets = std::forward<Other>(other).hand_buckets;
+    eligible_count = other.eligible_count;
+    star_histogram = std::forward<Other>(other).star_histogram;
+    safe_actors = std::forward<Other>(other).safe_actors;
+    eliminated_actors = std::forward<Other>(other).eliminated_actors;
+    filings = std::forward<Other>(other).filings;
+    dense_buckets = std::forward<Other>(other).dense_buckets;
+    sparse_buckets = std::forward<Other>(other).sparse_buckets;
+    dirty_slots = std::forward<Other>(other).dirty_slots;
+    dirty = std::forward<Other>(other).dirty;
+}
+
+void Global::touch(ActorHandle handle) {
+    if (dirty.size() <= handle.slot) dirty.resize(actors.slot_count());
+    if (dirty[handle.slot]) return;
+    dirty[handle.slot] = true;
+    dirty_slots.push_back(handle.slot);
+}
+
+void Global::refresh() {
+    auto refresh_slot = [&](uint32_t slot) {
+        dirty[slot] = false;
+
+        // The actor now in the slot, if any; a removed actor simply drops out
+        ActorHandle handle{slot, actors.slot_generation(slot)};
+        if (actors.contains(handle)) file(handle, actors[handle]);
+        else unfile(slot);
+    };
+
+    // Phases touch actors in shuffled order; once a good share of them is dirty,
+    // walking the flags in slot order beats jumping around memory
+    if (dirty_slots.size() * 8 > dirty.size()) {
+        for (uint32_t slot = 0; slot < dirty.size(); ++slot)
+            if (dirty[slot]) refresh_slot(slot);
+    } else {
+        for (uint32_t slot : dirty_slots)
+            refresh_slot(slot);
+    }
+    dirty_slots.clear();
+}
+
+uint32_t Global::hand_key(const Actor& actor) {
+    return (uint32_t) actor.stone_count | (uint32_t) actor.scissor_count << 10 | (uint32_t) actor.paper_count << 20;
+}
+
+// Drop the last element of a list into the gap at position, and tell the moved element where it went
+template<typename Moved>
+static void swap_remove(std::vector<ActorHandle>& list, uint32_t position, Moved moved) {
+    ActorHandle last = list.back();
+    list[position] = last;
+    list.pop_back();
+    if (position < list.size()) moved(last, position);
+}
+
+int32_t Global::bucket_of(const Actor& actor) {
+    if (!actor.can_compete()) return -1;
+
+    // Hands stay small, so most are found in a dense table without hashing
+    int32_t* index;
+    if (actor.stone_count < dense_limit && actor.scissor_count < dense_limit && actor.paper_count < dense_limit) {
+        if (dense_buckets.empty()) dense_buckets.assign(dense_limit * dense_limit * dense_limit, -1);
+        index = &dense_buckets[(actor.stone_count * dense_limit + actor.scissor_count) * dense_limit + actor.paper_count];
+    } else
+        index = &sparse_buckets.try_emplace(hand_key(actor), -1).first->second;
+
+    if (*index < 0) {
+        *index = (int32_t) hand_buckets.size();
+        hand_buckets.push_back(HandBucket{hand_key(actor), {}});
+    }
+    return *index;
+}
+
+// The smallest spare buffer holding at least wanted handles, or nullptr
+static std::vector<ActorHandle>* smallest_spare(std::vector<std::vector<ActorHandle>>& spares, size_t wanted) {
+    std::vector<ActorHandle>* best = nullptr;
+    for (auto& spare : spares)
+        if (spare.capacity() >= wanted && (best == nullptr || spare.capacity() < best->capacity()))
+            best = &spare;
+    return best;
+}
+
+// Move members into the spare, which takes the old buffer in exchange
+static void exchange_buffer(std::vector<ActorHandle>& members, std::vector<ActorHandle>& spare) {
+    spare.assign(members.begin(), members.end());
+    std::swap(members, spare);
+    spare.clear();
+}
+
+void Global::push_member(std::vector<ActorHandle>& members, ActorHandle handle) {
+    if (members.size() == members.capacity()) {
+        // The smallest spare with twice the room, or a new buffer that becomes a spare once traded in
+        size_t wanted = std::max<size_t>(2 * members.size(), 16);
+        auto* spare = smallest_spare(spare_members, wanted);
+        if (spare == nullptr) {
+            spare_members.emplace_back();
+            spare = &spare_members.back();
+            spare->reserve(wanted);
+        }
+        exchange_buffer(members, *spare);
+        if (spare->capacity() == 0) {
+            if (spare != &spare_members.back()) *spare = std::move(spare_members.back());
+            spare_members.pop_back();
+        }
+    }
+    members.push_back(handle);
+}
+
+void Global::retire_members(std::vector<ActorHandle>& members) {
+    if (members.capacity() == 0) return;
+    spare_members.push_back(std::move(members));
+    members.clear();
+}
+
+void Global::file(ActorHandle handle, const Actor& actor) {
+    if (filings.size() <= handle.slot) filings.resize(actors.slot_count());
+    auto& filing = filings[handle.slot];
+
+    // A slot that moved on to a new actor starts over
+    if (filing.filed && filing.generation != handle.generation) unfile(handle.slot);
+    bool fresh = !filing.filed;
+    filing.filed = true;
+    filing.generation = handle.generation;
+
+    // Each aggregate is only updated where the actor's contribution changed
+    int32_t bucket = bucket_of(actor);
+    if (fresh || bucket != filing.bucket) {
+        if (!fresh && filing.bucket >= 0) {
+            auto& members = hand_buckets[filing.bucket].members;
+            swap_remove(members, filing.bucket_position,
+                        [&](ActorHandle moved, uint32_t position) { filings[moved.slot].bucket_position = position; });
+            if (members.empty()) retire_members(members);
+            --eligible_count;
+        }
+        filing.bucket = bucket;
+        if (bucket >= 0) {
+            auto& members = hand_buckets[bucket].members;
+            filing.bucket_position = (uint32_t) members.size();
+            push_member(members, handle);
+            ++eligible_count;
+        }
+    }
+
+    int star_index = std::max(actor.star_count, 0);
+    if (fresh || star_index != filing.star_index) {
+        if (!fresh) --star_histogram[filing.star_index];
+        filing.star_index = star_index;
+        if (star_histogram.size() <= (size_t) star_index) star_histogram.resize(star_index + 1);
+        ++star_histogram[star_index];
+    }
+
+    auto check = check_actor(*this, actor);
+    if (fresh || check != filing.check) {
+        if (!fresh && filing.check != CheckResult::CONTINUE) {
+            auto& list = filing.check == CheckResult::WIN ? safe_actors : eliminated_actors;
+            swap_remove(list, filing.check_position,
+                        [&](ActorHandle moved, uint32_t position) { filings[moved.slot].check_position = position; });
+        }
+        filing.check = check;
+        if (check != CheckResult::CONTINUE) {
+            auto& list = check == CheckResult::WIN ? safe_actors : eliminated_actors;
+            filing.check_position = (uint32_t) list.size();
+            list.push_back(handle);
+        }
+    }
+}
+
+void Global::unfile(uint32_t slot) {
+    if (filings.size() <= slot || !filings[slot].filed) return;
+    auto& filing = filings[slot];
+
+    if (filing.bucket >= 0) {
+        auto& members = hand_buckets[filing.bucket].members;
+        swap_remove(members, filing.bucket_position,
+                    [&](ActorHandle moved, uint32_t position) { filings[moved.slot].bucket_position = position; });
+        if (members.empty()) retire_members(members);
+        --eligible_count;
+    }
+
+    --star_histogram[filing.star_index];
+
+    if (filing.check != CheckResult::CONTINUE) {
+        auto& list = filing.check == CheckResult::WIN ? safe_actors : eliminated_actors;
+        swap_remove(list, filing.check_position,
+                    [&](ActorHandle moved, uint32_t position) { filings[moved.slot].check_position = position; });
+    }
+
+    filing = Filing{};
+}
+
+void CardCounts::add_card(Card card) {
+    switch (card) {
+        case Card::STONE:
+            ++stone_count;
+            break;
+        case Card::SCISSOR:
+            ++scissor_count;
+            break;
+        case Card::PAPER:
+            ++paper_count;
+            break;
+    }
+}
+
+void CardCounts::remove_card(Card card) {
+    switch (card) {
+        case Card::STONE:
+            --stone_count;
+            break;
+        case Card::SCISSOR:
+            --scissor_count;
+            break;
+        case Card::PAPER:
+            --paper_count;
+            break;
+    }
+}
+
+void Global::display_all() const {
+    Frame frame;
+    render_counts(frame, *this);
+    for (auto& actor : actors)
+        render_actor_all(frame, *this, actor);
+    frame << "\n\n";
+    frame.present(cout);
+}
+
+void Global::display_concise() const {
+    Frame frame;
+    render_counts(frame, *this);
+    frame << "\nName\t\tStars\n";
+    for (auto& actor : actors)
+        render_actor_concise(frame, actor);
+    frame << '\n';
+    frame.present(cout);
+}
+
+ActorRegistry init_actors(int total_count, const vector<std::string_view>& names, const Rules& rules) {
+    ActorRegistry actors;
+
+    for (int i = 0; i < total_count; ++i) {
+        Actor actor{};
+        actor.id = i + 1;
+        // Batch runs may ask for more actors than there are names
+        if (!names.empty()) actor.name = names[i % names.size()];
+        actor.stone_count = rules.stone_count;
+        actor.scissor_count = rules.scissor_count;
+        actor.paper_count = rules.paper_count;
+        actor.star_count = rules.star_count;
+        actors.add(actor);
+    }
+
+    return actors;
+}
+
+void consume_card(Global& global, Actor& actor, Card card) {
+    actor.remove_card(card);
+    global.remove_card(card);
+    trace_event(EventType::CARD_CONSUMED, actor.id, -1, (uint8_t) card);
+}
+
+CheckResult check_actor(Global& global, const Actor& actor) {
+    if (actor.star_count >= global.rules.safe_star_count && actor.total_count() <= 0) return CheckResult::WIN;
+    if (actor.star_count <= global.rules.eliminated_star_count) return CheckResult::LOSE;
+    return CheckResult::CONTINUE;
+}
+
+void verbose_check_actor(Global& global, const Actor& actor) {
+    Frame frame;
+    render_check_actor(frame, global, actor);
+    frame.present(cout);
+}
+
+void remove_actors(Global& global) {
+    PROFILE_PHASE(Phase::ELIMINATION);
+    global.refresh();
+
+    // Only actors that changed can have become safe or eliminated, and refresh() has filed them already
+    for (auto* list : {&global.safe_actors, &global.eliminated_actors}) {
+        auto type = list == &global.safe_actors ? EventType::ACTOR_SAFE : EventType::ACTOR_ELIMINATED;
+        for (auto handle : *list) {
+            trace_event(type, global.actors[handle].id);
+            global.actors.remove(handle);
+            global.touch(handle);
+        }
+    }
+    global.refresh();
+}
+
+void finish_round(Global& global) {
+    PROFILE_PHASE(Phase::ELIMINATION);
+    global.actors.compact();
+    ++global.round;
+}
+
+// Odds of meeting each card among the cards held by everyone else
+static CardProb others_prob(int stone_count, int scissor_count, int paper_count) {
+    int total_count = stone_count + scissor_count + paper_count;
+    CardProb prob;
+
+    if (total_count != 0) {
+        prob[Card::STONE] = (float) stone_count / (float) total_count;
+        prob[Card::SCISSOR] = (float) scissor_count / (float) total_count;
+        prob[Card::PAPER] = (float) paper_count / (float) total_count;
+    }
+    return prob;
+}
+
+CardProb competitor_prob(const CardCounts& counts, const Actor& actor) {
+    PROFILE_COUNT(Counter::PROBABILITY_CALLS);
+    return others_prob(counts.stone_count - actor.stone_count,
+                       counts.scissor_count - actor.scissor_count,
+                       counts.paper_count - actor.paper_count);
+}
+
+// Only whether the hand holds each card matters, not how many
+static float predict_success(const CardProb& prob, int stone_count, int scissor_count, int paper_count) {
+    float stone = prob[Card::STONE];
+    float scissor = prob[Card::SCISSOR];
+    float paper = prob[Card::PAPER];
+
+    float beat_stone = paper_count > 0 ? stone * stone : 0;
+    float beat_scissor = stone_count > 0 ? scissor * scissor : 0;
+    float beat_paper = scissor_count > 0 ? paper * paper : 0;
+
+    return beat_stone + beat_scissor + beat_paper;
+}
+
+static float predict_fail(const CardProb& prob, int stone_count, int scissor_count, int paper_count) {
+    float stone = prob[Card::STONE];
+    float scissor = prob[Card::SCISSOR];
+    float paper = prob[Card::PAPER];
+
+    float fail_stone = scissor_count > 0 ? stone * paper : 0;
+    float fail_scissor = paper_count > 0 ? scissor * stone : 0;
+    float fail_paper = stone_count > 0 ? paper * scissor : 0;
+
+    return fail_stone + fail_scissor + fail_paper;
+}
+
+const Prediction& actor_predict(const CardCounts& counts, const Actor& actor) {
+    PROFILE_COUNT(Counter::PROBABILITY_CALLS);
+    auto& prediction = actor.prediction;
+    if (prediction.valid &&
+        prediction.stone_count == counts.stone_count &&
+        prediction.scissor_count == counts.scissor_count &&
+        prediction.paper_count == counts.paper_count)
+        return prediction;
+
+    auto prob = competitor_prob(counts, actor);
+    prediction.valid = true;
+    prediction.stone_count = counts.stone_count;
+    prediction.scissor_count = counts.scissor_count;
+    prediction.paper_count = counts.paper_count;
+    prediction.success = predict_success(prob, actor.stone_count, actor.scissor_count, actor.paper_count);
+    prediction.fail = predict_fail(prob, actor.stone_count, actor.scissor_count, actor.paper_count);
+    return prediction;
+}
+
+// Predict the odds of success
+float actor_predict_success(const CardCounts& counts, const Actor& actor) {
+    return actor_predict(counts, actor).success;
+}
+
+float actor_predict_fail(const CardCounts& counts, const Actor& actor) {
+    return actor_predict(counts, actor).fail;
+}
+
+float actor_compete_will(const CardCounts& counts, const Actor& actor) {
+    PROFILE_COUNT(Counter::WILL_CALLS);
+    auto& prediction = actor_predict(counts, actor);
+    return prediction.success - prediction.fail;
+}
+
+float actor_compete_will_after(const CardCounts& counts, const Actor& actor, const CardDelta& delta) {
+    PROFILE_COUNT(Counter::WILL_CALLS);
+    int stone_count = actor.stone_count + delta[Card::STONE];
+    int scissor_count = actor.scissor_count + delta[Card::SCISSOR];
+    int paper_count = actor.paper_count + delta[Card::PAPER];
+
+    // A card the actor gains leaves the global pool, so the other hands lose it twice over
+    auto prob = others_prob(counts.stone_count - actor.stone_count - 2 * delta[Card::STONE],
+                            counts.scissor_count - actor.scissor_count - 2 * delta[Card::SCISSOR],
+                            counts.paper_count - actor.paper_count - 2 * delta[Card::PAPER]);
+
+    float success = predict_success(prob, stone_count, scissor_count, paper_count);
+    float fail = predict_fail(prob, stone_count, scissor_count, paper_count);
+    return success - fail;
+}
+
+// draw(sum) returns a random float in [0, sum)
+template<typename Draw>
+static Card actor_compete_with(const CardCounts& counts, const Actor& actor, Draw draw) {
+    assert(actor.can_compete());
+    auto prob = competitor_prob(counts, actor);
+
+    float sum = 0;
+    if (actor.paper_count > 0) sum += prob[Card::STONE];
+    if (actor.stone_count > 0) sum += prob[Card::SCISSOR];
+    if (actor.scissor_count > 0) sum += prob[Card::PAPER];
+
+    auto rand = draw(sum);
+
+    sum = 0;
+    if (actor.paper_count > 0) {
+        sum += prob[Card::STONE];
+        if (sum >= rand) return Card::PAPER;
+    }
+    if (actor.stone_count > 0) {
+        sum += prob[Card::SCISSOR];
+        if (sum >= rand) return Card::STONE;
+    }
+    if (actor.scissor_count > 0) return Card::SCISSOR;
+
+    assert(false);
+}
+
+Card actor_compete(const CardCounts& counts, const Actor& actor) {
+    return actor_compete_with(counts, actor, [](float sum) {
+        auto dist = std::uniform_real_distribution<float>(0, sum);
+        return dist(generator);
+    });
+}
+
+// The lookahead that decides for the actor, if any
+static Lookahead* lookahead_of(const Global& global, const Actor& actor) {
+    return global.lookahead != nullptr && global.lookahead->controls(actor) ? global.lookahead : nullptr;
+}
+
+Card npc_compete(const Global& global, const CardCounts& counts, const Actor& actor, const Actor& opponent) {
+    if (auto* lookahead = lookahead_of(global, actor))
+        return lookahead->choose_card(global, counts, actor, opponent);
+    return actor_compete(counts, actor);
+}
+
+CardProb actor_compete_odds(const CardCounts& counts, const Actor& actor) {
+    assert(actor.can_compete());
+    auto prob = competitor_prob(counts, actor);
+    CardProb odds;
+
+    float sum = 0;
+    if (actor.paper_count > 0) sum += prob[Card::STONE];
+    if (actor.stone_count > 0) sum += prob[Card::SCISSOR];
+    if (actor.scissor_count > 0) sum += prob[Card::PAPER];
+
+    if (sum <= 0) {
+        // Nothing to beat; actor_compete settles on the first card it has
+        if (actor.paper_count > 0) odds[Card::PAPER] = 1;
+        else if (actor.stone_count > 0) odds[Card::STONE] = 1;
+        else odds[Card::SCISSOR] = 1;
+        return odds;
+    }
+
+    if (actor.paper_count > 0) odds[Card::PAPER] = prob[Card::STONE] / sum;
+    if (actor.stone_count > 0) odds[Card::STONE] = prob[Card::SCISSOR] / sum;
+    if (actor.scissor_count > 0) odds[Card::SCISSOR] = prob[Card::PAPER] / sum;
+    return odds;
+}
+
+// The outcome of c1 against c2 worked out without a table lookup, so that it vectorizes:
+// c1 wins exactly when c2 is the card after it, cyclically
+static constexpr int8_t outcome_of(int c1, int c2) {
+    int difference = c2 - c1;
+    return (int8_t) (difference - 3 * (difference > 1) + 3 * (difference < -1));
+}
+
+static constexpr bool outcome_matches_table() {
+    for (int c1 = 0; c1 < 3; ++c1)
+        for (int c2 = 0; c2 < 3; ++c2)
+            if (outcome_of(c1, c2) != compete_outcomes[c1][c2]) return false;
+    return true;
+}
+
+static_assert(outcome_matches_table(), "outcome_of must agree with compete_outcomes");
+
+void resolve_matches(const uint8_t* cards1, const uint8_t* cards2, size_t count, int8_t* stars1, int used[3]) {
+    int stone = 0, scissor = 0, paper = 0;
+    for (size_t i = 0; i < count; ++i) {
+        int c1 = cards1[i], c2 = cards2[i];
+        stars1[i] = outcome_of(c1, c2);
+
+        stone += (c1 == (int) Card::STONE) + (c2 == (int) Card::STONE);
+        scissor += (c1 == (int) Card::SCISSOR) + (c2 == (int) Card::SCISSOR);
+        paper += (c1 == (int) Card::PAPER) + (c2 == (int) Card::PAPER);
+    }
+    used[(int) Card::STONE] = stone;
+    used[(int) Card::SCISSOR] = scissor;
+    used[(int) Card::PAPER] = paper;
+}
+
+void choose_compete_cards(const Global& global, const HandleList& list,
+                          std::pmr::vector<uint8_t>& cards1, std::pmr::vector<uint8_t>& cards2) {
+    choose_compete_cards(global, list, cards1, cards2, DefaultStrategy{});
+}
+
+// Move the stars of one match to its winner
+static void settle_match(Actor& a1, Actor& a2, Card c1, Card c2) {
+    int result = single_compete(c1, c2);
+    if (result == 1) {
+        // A1 win
+        a1.star_count++;
+        a2.star_count--;
+    } else if (result == -1) {
+        // A1 lose
+        a1.star_count--;
+        a2.star_count++;
+    }
+}
+
+void auto_compete(Global& global, const HandleList& list) {
+    auto_compete(global, list, DefaultStrategy{});
+}
+
+// Cards used up by the matches one worker resolved, padded so that workers do not share a cache line
+struct alignas(64) CardUsage {
+    int counts[3];
+};
+
+// The card a hand plays as a compact CDF over the cards it holds, in the order actor_compete tries them:
+// a unit draw below thresholds[0] plays cards[0], below thresholds[1] cards[1], otherwise cards[2]
+struct CardSampler {
+    float thresholds[2];
+    Card cards[3];
+
+    [[nodiscard]] Card operator()(float unit) const {
+        return unit < thresholds[0] ? cards[0] : unit < thresholds[1] ? cards[1] : cards[2];
+    }
+};
+
+static CardSampler make_sampler(const Global& global, const Actor& actor) {
+    auto odds = actor_compete_odds(global, actor);
+
+    Card held[3];
+    int held_count = 0;
+    if (actor.paper_count > 0) held[held_count++] = Card::PAPER;
+    if (actor.stone_count > 0) held[held_count++] = Card::STONE;
+    if (actor.scissor_count > 0) held[held_count++] = Card::SCISSOR;
+
+    // The last card held takes whatever rounding leaves over, so a card the hand lacks is never played
+    CardSampler sampler{};
+    float sum = 0;
+    for (int i = 0; i < 3; ++i) {
+        Card card = held[std::min(i, held_count - 1)];
+        sampler.cards[i] = card;
+        if (i < 2) {
+            sum += odds[card];
+            sampler.thresholds[i] = i < held_count - 1 ? sum : 2.0f;
+        }
+    }
+    return sampler;
+}
+
+// Samplers for every hand tuple in a compete list, built once per phase while the global counts hold still.
+// Hands are few and small, so a tuple indexes a dense table directly; larger hands fall back to actor_compete.
+class SamplerTable {
+public:
+    static constexpr int count_limit = 16;
+
+    SamplerTable(const Global& global, const HandleList& list)
+            : samplers(count_limit * count_limit * count_limit, round_resource()),
+              built(samplers.size(), round_resource()) {
+        for (auto handle : list) {
+            const Actor& actor = global.actors[handle];
+            int index = index_of(actor);
+            if (index >= 0 && !built[index]) {
+                samplers[index] = make_sampler(global, actor);
+                built[index] = true;
+            }
+        }
+    }
+
+    [[nodiscard]] const CardSampler* find(const Actor& actor) const {
+        int index = index_of(actor);
+        return index >= 0 ? &samplers[index] : nullptr;
+    }
+
+private:
+    static int index_of(const Actor& actor) {
+        if (actor.stone_count >= count_limit || actor.scissor_count >= count_limit ||
+            actor.paper_count >= count_limit)
+            return -1;
+        return (actor.stone_count * count_limit + actor.scissor_count) * count_limit + actor.paper_count;
+    }
+
+    std::pmr::vector<CardSampler> samplers;
+    std::pmr::vector<uint8_t> built;
+};
+
+void auto_compete_parallel(Global& global, const HandleList& list, ThreadPool& pool,
+                           uint64_t seed, uint32_t round) {
+    PROFILE_PHASE(Phase::COMPETITION);
+    assert(list.size() % 2 == 0);
+
+    // Every match sees the counts as they were when the phase began, so a hand always plays the same odds
+    const Global& frozen = global;
+    SamplerTable samplers(frozen, list);
+    Philox philox(seed);
+    std::pmr::vector<CardUsage> usages(pool.size(), CardUsage{{0, 0, 0}}, round_resource());
+
+    // NPCs under the lookahead decide by it, on the frozen counts too; its decisions are keyed by the game,
+    // the round and the actors, so they do not depend on the thread either
+    auto choose = [&](const Actor& actor, const Actor& opponent, uint32_t bits) {
+        if (auto* lookahead = lookahead_of(frozen, actor))
+            return lookahead->choose_card(frozen, frozen, actor, opponent);
+
+        float unit = Philox::unit(bits);
+        if (auto sampler = samplers.find(actor)) return (*sampler)(unit);
+        return actor_compete_with(frozen, actor, [&](float sum) { return unit * sum; });
+    };
+
+    EventChannel* trace = trace_channel();
+    pool.parallel_for(list.size() / 2, [&](size_t pair, int worker) {
+        TraceScope trace_scope(worker_trace_channel(trace, worker));
+        Actor& a1 = global.actors[list[2 * pair]];
+        Actor& a2 = global.actors[list[2 * pair + 1]];
+
+        auto block = philox({(uint32_t) pair, (uint32_t) (pair >> 32), round, 0});
+        Card c1 = choose(a1, a2, block[0]);
+        Card c2 = choose(a2, a1, block[1]);
+
+        a1.remove_card(c1);
+        a2.remove_card(c2);
+        ++usages[worker].counts[(int) c1];
+        ++usages[worker].counts[(int) c2];
+
+        settle_match(a1, a2, c1, c2);
+        if (trace != nullptr) trace_match(a1, a2, c1, c2, single_compete(c1, c2));
+    }, 256);
+
+    for (auto& usage : usages) {
+        global.stone_count -= usage.counts[(int) Card::STONE];
+        global.scissor_count -= usage.counts[(int) Card::SCISSOR];
+        global.paper_count -= usage.counts[(int) Card::PAPER];
+    }
+    for (auto handle : list)
+        global.touch(handle);
+}
+
+// The sort-based ranking compete_top replaced, kept as the reference the bench times it against
+HandleList compete_candidates(const Global& global) {
+    PROFILE_PHASE(Phase::CANDIDATES);
+    // Decorate each candidate with its will once, instead of recomputing it in every comparison
+    std::pmr::vector<std::pair<float, ActorHandle>> decorated(round_resource());
+    decorated.reserve(global.actors.size());
+    for (auto& actor : global.actors)
+        if (actor.can_compete()) decorated.emplace_back(actor_compete_will(global, actor), global.actors.handle(actor));
+
+    std::sort(decorated.begin(), decorated.end(),
+              [](auto& a1, auto& a2) { return a1.first > a2.first; });
+
+    HandleList candidates(decorated.size(), round_resource());
+    std::transform(decorated.begin(), decorated.end(), candidates.begin(), [](auto& pair) { return pair.second; });
+    return candidates;
+}
+
+HandleList compete_list(const HandleList& candidates) {
+    PROFILE_PHASE(Phase::LISTS);
+    auto dist = std::uniform_int_distribution<int>(0, candidates.size());
+    int rand = dist(generator);
+
+    // Ensure that we always take even candidates
+    if (rand % 2 == 1) --rand;
+    auto begin = candidates.begin();
+    auto end = begin + rand;
+
+    HandleList list(rand, round_resource());
+    std::copy(begin, end, list.begin());
+
+    std::shuffle(list.begin(), list.end(), generator);
+    return list;
+}
+
+static CardDelta single_delta(Card card, int count) {
+    CardDelta delta;
+    delta[card] = count;
+    return delta;
+}
+
+// Whether this actor will receive the card
+bool can_receive_card(const Global& global, const Actor& actor, Card card) {
+    if (auto* lookahead = lookahead_of(global, actor))
+        return lookahead->will_trade(global, actor, single_delta(card, 1));
+
+    // Will never receive card in this case
+    if (actor.star_count >= global.rules.safe_star_count) return false;
+
+    float current_will = actor_compete_will(global, actor);
+    return actor_compete_will_after(global, actor, single_delta(card, 1)) >= current_will;
+}
+
+bool can_give_card(const Global& global, const Actor& actor, Card card) {
+    if (actor.card_count(card) <= 0) return false;
+    if (auto* lookahead = lookahead_of(global, actor))
+        return lookahead->will_trade(global, actor, single_delta(card, -1));
+    if (actor.star_count >= global.rules.safe_star_count) return true;
+
+    float current_will = actor_compete_will(global, actor);
+    return actor_compete_will_after(global, actor, single_delta(card, -1)) >= current_will;
+}
+
+bool can_switch_card(const Global& global, const Actor& actor, Card from, Card to) {
+    if (actor.card_count(from) <= 0) return false;
+
+    CardDelta delta;
+    delta[from] -= 1;
+    delta[to] += 1;
+
+    float current_will = actor_compete_will(global, actor);
+    return actor_compete_will_after(global, actor, delta) >= current_will;
+}
+
+CardFlags receivable_cards(const Global& global, const Actor& actor) {
+    CardFlags flags;
+    if (lookahead_of(global, actor) != nullptr) {
+        for (int i = 0; i < 3; ++i)
+            flags.values[i] = can_receive_card(global, actor, (Card) i);
+        return flags;
+    }
+    if (actor.star_count >= global.rules.safe_star_count) return flags;
+
+    float current_will = actor_compete_will(global, actor);
+    for (int i = 0; i < 3; ++i)
+        flags.values[i] = actor_compete_will_after(global, actor, single_delta((Card) i, 1)) >= current_will;
+    return flags;
+}
+
+CardFlags givable_cards(const Global& global, const Actor& actor) {
+    CardFlags flags;
+    if (lookahead_of(global, actor) != nullptr) {
+        for (int i = 0; i < 3; ++i)
+            flags.values[i] = can_give_card(global, actor, (Card) i);
+        return flags;
+    }
+    for (int i = 0; i < 3; ++i)
+        flags.values[i] = actor.card_count((Card) i) > 0;
+    if (actor.star_count >= global.rules.safe_star_count) return flags;
+
+    float current_will = actor_compete_will(global, actor);
+    for (int i = 0; i < 3; ++i)
+        if (flags.values[i])
+            flags.values[i] = actor_compete_will_after(global, actor, single_delta((Card) i, -1)) >= current_will;
+    return flags;
+}
+
+void give_card(Actor& giver, Actor& receiver, Card card, bool verbose) {
+    assert(giver.card_count(card) > 0);
+    giver.remove_card(card);
+    receiver.add_card(card);
+    trace_event(EventType::CARD_GIVEN, giver.id, receiver.id, (uint8_t) card);
+    if (verbose) cout << giver.name << " gives " << ::verbose(card) << " to " << receiver.name << endl;
+}
+
+bool negotiate(const Global& global, Actor& a1, Actor& a2) {
+    return negotiate(global, a1, a2, DefaultStrategy{});
+}
+
+void auto_negotiate(Global& global, const HandleList& list) {
+    auto_negotiate(global, list, DefaultStrategy{});
+}
+
+void auto_negotiate_parallel(Global& global, const HandleList& list, ThreadPool& pool) {
+    auto_negotiate_parallel(global, list, pool, DefaultStrategy{});
+}
+
+// The strategies built into the library, see game_phases.h
+template void choose_compete_cards(const Global&, const HandleList&, std::pmr::vector<uint8_t>&,
+                                   std::pmr::vector<uint8_t>&, const DefaultStrategy&);
+template void auto_compete(Global&, const HandleList&, const DefaultStrategy&);
+template bool negotiate(const Global&, Actor&, Actor&, const DefaultStrategy&);
+template void auto_negotiate(Global&, const HandleList&, const DefaultStrategy&);
+template void auto_negotiate_parallel(Global&, const HandleList&, ThreadPool&, const DefaultStrategy&);
+template void choose_compete_cards(const Global&, const HandleList&, std::pmr::vector<uint8_t>&,
+                                   std::pmr::vector<uint8_t>&, const Tournament&);
+template void auto_compete(Global&, const HandleList&, const Tournament&);
+template bool negotiate(const Global&, Actor&, Actor&, const Tournament&);
+template void auto_negotiate(Global&, const HandleList&, const Tournament&);
+template void auto_negotiate_parallel(Global&, const HandleList&, ThreadPool&, const Tournament&);
+
+HandleList negotiate_candidates(const Global& global, const HandleList& compete_list) {
+    PROFILE_PHASE(Phase::CANDIDATES);
+    auto& actors = global.actors;
+
+    // Slots are not reused before the round ends, so marking them is enough
+    std::pmr::vector<bool> competing(actors.slot_count(), false, round_resource());
+    for (auto handle : compete_list)
+        competing[handle.slot] = true;
+
+    HandleList candidates(round_resource());
+    candidates.reserve(actors.size());
+    for (auto& actor : actors) {
+        auto handle = actors.handle(actor);
+        if (!competing[handle.slot]) candidates.push_back(handle);
+    }
+    return candidates;
+}
+
+HandleList negotiate_list(const HandleList& candidates) {
+    PROFILE_PHASE(Phase::LISTS);
+    int count = candidates.size();
+    if (count % 2 == 1) --count;
+    auto begin = candidates.begin();
+    auto end = candidates.begin() + count;
+
+    HandleList list(count, round_resource());
+    std::copy(begin, end, list.begin());
+    std::shuffle(list.begin(), list.end(), generator);
+    return list;
+}
+
+void Actor::display_all(const Global& global) const {
+    Frame frame;
+    render_actor_all(frame, global, *this);
+    frame.present(cout);
+}
+
+void Actor::display_concise(const Global& global) const {
+    Frame frame;
+    render_actor_concise(frame, *this);
+    frame.present(cout);
+}
@@ -0,0 +1,469 @@
+#ifndef ANIMAL_WORLD_GAME_H
+#define ANIMAL_WORLD_GAME_H
+
+#include "profiler.h"
+
+#include <vector>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <random>
+#include <iterator>
+#include <cstdint>
+#include <unordered_map>
+
+class ThreadPool;
+class Lookahead;
+
+// std::default_random_engine, counting its draws in profiling builds
+class GameEngine : public std::default_random_engine {
+public:
+    using std::default_random_engine::default_random_engine;
+
+    GameEngine(const std::default_random_engine& engine) : std::default_random_engine{engine} {}
+
+    result_type operator()() {
+        PROFILE_COUNT(Counter::RNG_DRAWS);
+        return std::default_random_engine::operator()();
+    }
+};
+
+// Each thread owns its own engine so that independent games can run side by side
+extern thread_local GameEngine generator;
+
+enum class Card {
+    STONE,
+    SCISSOR,
+    PAPER,
+};
+
+std::string verbose(Card card);
+
+enum class CheckResult {
+    WIN,
+    LOSE,
+    CONTINUE,
+};
+
+// The numbers a game is played by; the defaults are those of the game itself
+struct Rules {
+    // What every actor starts with
+    int stone_count = 2;
+    int scissor_count = 2;
+    int paper_count = 2;
+    int star_count = 3;
+
+    // An actor holding at least safe_star_count stars and no cards is safe, and one holding
+    // eliminated_star_count or fewer is eliminated. Actors at the safe count no longer take cards in trades.
+    int safe_star_count = 3;
+    int eliminated_star_count = 0;
+};
+
+struct Global;
+
+// Odds of meeting each kind of card, indexed by Card
+struct CardProb {
+    float values[3] = {0, 0, 0};
+
+    float& operator[](Card card) { return values[(int) card]; }
+
+    float operator[](Card card) const { return values[(int) card]; }
+};
+
+// A change to each card count of a hand, indexed by Card
+struct CardDelta {
+    int values[3] = {0, 0, 0};
+
+    int& operator[](Card card) { return values[(int) card]; }
+
+    int operator[](Card card) const { return values[(int) card]; }
+};
+
+// A yes or no for each kind of card, indexed by Card
+struct CardFlags {
+    bool values[3] = {false, false, false};
+
+    bool& operator[](Card card) { return values[(int) card]; }
+
+    bool operator[](Card card) const { return values[(int) card]; }
+};
+
+// Odds predicted for a hand, valid while the hand and the global counts stay the same
+struct Prediction {
+    bool valid = false;
+
+    int stone_count = 0;
+    int scissor_count = 0;
+    int paper_count = 0;
+
+    float success = 0;
+    float fail = 0;
+};
+
+struct Actor {
+    int id;
+    // Points into the NamePool the actor was named from
+    std::string_view name;
+
+    int stone_count;
+    int scissor_count;
+    int paper_count;
+
+    int star_count;
+
+    mutable Prediction prediction{};
+
+    bool operator==(const Actor& other) const { return id == other.id; }
+
+    [[nodiscard]] int total_count() const { return stone_count + scissor_count + paper_count; }
+
+    [[nodiscard]] bool can_compete() const {
+        bool result = stone_count > 0 || scissor_count > 0 || paper_count > 0;
+        return result;
+    }
+
+    [[nodiscard]] int card_count(Card card) const;
+
+    void add_card(Card card);
+
+    void remove_card(Card card);
+
+    void display_all(const Global& global) const;
+
+    void display_concise(const Global& global) const;
+};
+
+// Names an actor in an ActorRegistry. A handle outlives its actor safely: once the actor is gone,
+// its slot moves on to a new generation and the old handle no longer matches.
+struct ActorHandle {
+    uint32_t slot;
+    uint32_t generation;
+
+    bool operator==(const ActorHandle& other) const { return slot == other.slot && generation == other.generation; }
+
+    bool operator!=(const ActorHandle& other) const { return !(*this == other); }
+};
+
+// The lists a round builds; they come from round_resource(), see round_arena.h
+using HandleList = std::pmr::vector<ActorHandle>;
+
+// Actors stored densely in the order they were added. Removing an actor only leaves a tombstone;
+// compact() sweeps them out in one pass at the end of the round, so handles and references taken
+// during a round stay valid until then.
+class ActorRegistry {
+public:
+    // Visits the actors that are not removed, in the order they were added
+    template <typename T>
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Actor;
+        using difference_type = std::ptrdiff_t;
+        using pointer = T*;
+        using reference = T&;
+
+        Iterator(T* actor, T* end, const uint8_t* removed) : actor{actor}, end{end}, removed{removed} { skip(); }
+
+        T& operator*() const { return *actor; }
+
+        T* operator->() const { return actor; }
+
+        Iterator& operator++() {
+            ++actor;
+            ++removed;
+            skip();
+            return *this;
+        }
+
+        bool operator==(const Iterator& other) const { return actor == other.actor; }
+
+        bool operator!=(const Iterator& other) const { return actor != other.actor; }
+
+    private:
+        void skip() {
+            while (actor != end && *removed) {
+                ++actor;
+                ++removed;
+            }
+        }
+
+        T* actor;
+        T* end;
+        const uint8_t* removed;
+    };
+
+    ActorHandle add(const Actor& actor);
+
+    // Make room for count actors in all
+    void reserve(size_t count);
+
+    // Whether the handle still names an actor that is not removed
+    [[nodiscard]] bool contains(ActorHandle handle) const;
+
+    Actor& operator[](ActorHandle handle);
+
+    const Actor& operator[](ActorHandle handle) const;
+
+    // The handle of an actor stored in this registry
+    [[nodiscard]] ActorHandle handle(const Actor& actor) const;
+
+    // O(1); the actor is skipped from now on and its storage is reclaimed by compact()
+    void remove(ActorHandle handle);
+
+    // Close the gaps left by removed actors, keeping the others in order
+    void compact();
+
+    [[nodiscard]] size_t size() const { return actors.size() - removed_count; }
+
+    [[nodiscard]] bool empty() const { return size() == 0; }
+
+    // One past the highest slot in use, for tables indexed by ActorHandle::slot
+    [[nodiscard]] size_t slot_count() const { return slots.size(); }
+
+    // The generation a handle to the slot must carry to be current
+    [[nodiscard]] uint32_t slot_generation(uint32_t slot) const { return slots[slot].generation; }
+
+    Iterator<Actor> begin() { return {actors.data(), actors.data() + actors.size(), removed.data()}; }
+
+    Iterator<Actor> end() { return {actors.data() + actors.size(), actors.data() + actors.size(), nullptr}; }
+
+    [[nodiscard]] Iterator<const Actor> begin() const {
+        return {actors.data(), actors.data() + actors.size(), removed.data()};
+    }
+
+    [[nodiscard]] Iterator<const Actor> end() const {
+        return {actors.data() + actors.size(), actors.data() + actors.size(), nullptr};
+    }
+
+private:
+    struct Slot {
+        uint32_t generation;
+        uint32_t position;
+    };
+
+    // Dense storage, with the slot and tombstone of each position alongside
+    std::vector<Actor> actors;
+    std::vector<uint32_t> positions_slot;
+    std::vector<uint8_t> removed;
+    size_t removed_count = 0;
+
+    std::vector<Slot> slots;
+    std::vector<uint32_t> free_slots;
+};
+
+// How many cards of each kind are in play
+struct CardCounts {
+    int stone_count = 0;
+    int scissor_count = 0;
+    int paper_count = 0;
+
+    [[nodiscard]] int total_count() const { return stone_count + scissor_count + paper_count; }
+
+    void add_card(Card card);
+
+    void remove_card(Card card);
+};
+
+// The actors that hold one hand tuple
+struct HandBucket {
+    uint32_t key;
+    std::vector<ActorHandle> members;
+};
+
+// The card counts, plus aggregates over the actors that are kept up to date incrementally. Phases touch()
+// the actors they change, and refresh() folds in only those, so its cost follows activity, not population.
+struct Global : CardCounts {
+    ActorRegistry& actors;
+    Rules rules;
+
+    // Rounds finished so far
+    int round = 0;
+
+    // The game's seed, which the lookahead keys its decisions by
+    uint64_t seed = 0;
+
+    // Decides for the NPCs it controls instead of the heuristic when set, see lookahead.h
+    Lookahead* lookahead = nullptr;
+
+    // Actors that can compete, filed by hand tuple; empty buckets are kept for reuse
+    std::vector<HandBucket> hand_buckets;
+    long long eligible_count = 0;
+
+    // Number of actors indexed by star count, with negative counts filed under zero
+    std::vector<long long> star_histogram;
+
+    // Actors that check_actor reports as safe or eliminated, in no particular order
+    std::vector<ActorHandle> safe_actors;
+    std::vector<ActorHandle> eliminated_actors;
+
+    explicit Global(ActorRegistry& actors, const Rules& rules = {});
+
+    // The Global of a saved game, with its buckets in the same order and holding their members in the same
+    // order, so that the game plays on exactly as it would have
+    Global(ActorRegistry& actors, const CardCounts& counts, const std::vector<HandBucket>& buckets,
+           const Rules& rules = {});
+
+    // A copy of other over actors, which must be a copy of other.actors
+    Global(ActorRegistry& actors, const Global& other);
+
+    // Take over everything other keeps, once what other.actors holds has been moved into actors
+    void take(Global&& other);
+
+    // The actor's hand or stars changed, or it was removed
+    void touch(ActorHandle handle);
+
+    // Bring the aggregates up to date with every actor touched since the last refresh
+    void refresh();
+
+    [[nodiscard]] static uint32_t hand_key(const Actor& actor);
+
+    void display_all() const;
+
+    void display_concise() const;
+
+private:
+    // What each slot currently contributes to the aggregates
+    struct Filing {
+        bool filed = false;
+        uint32_t generation = 0;
+        int32_t bucket = -1;
+        uint32_t bucket_position = 0;
+        int star_index = 0;
+        CheckResult check = CheckResult::CONTINUE;
+        uint32_t check_position = 0;
+    };
+
+    // Copy or move everything but the registry from other
+    template<typename Other>
+    void assign(Other&& other);
+
+    // File an actor, or bring its filing up to date
+    void file(ActorHandle handle, const Actor& actor);
+
+    void unfile(uint32_t slot);
+
+    // The bucket of the actor's hand, created on first use; -1 when it cannot compete
+    int32_t bucket_of(const Actor& actor);
+
+    // Append to a bucket's members, growing into a spare buffer when one is large enough
+    void push_member(std::vector<ActorHandle>& members, ActorHandle handle);
+
+    // Keep the buffer of a bucket that has emptied for the next bucket to grow
+    void retire_members(std::vector<ActorHandle>& members);
+
+    std::vector<Filing> filings;
+
+    static constexpr int dense_limit = 16;
+    std::vector<int32_t> dense_buckets;
+    std::unordered_map<uint32_t, int32_t> sparse_buckets;
+
+    std::vector<uint32_t> dirty_slots;
+    std::vector<uint8_t> dirty;
+
+    // Buffers given up by buckets that grew or emptied. Actors move between hands every round, so buckets
+    // grow and shrink in turn; passing buffers on keeps that off the heap once the game has settled.
+    std::vector<std::vector<ActorHandle>> spare_members;
+};
+
+ActorRegistry init_actors(int total_count, const std::vector<std::string_view>& names, const Rules& rules = {});
+
+void consume_card(Global& global, Actor& actor, Card card);
+
+CheckResult check_actor(Global& global, const Actor& actor);
+
+void verbose_check_actor(Global& global, const Actor& actor);
+
+// Mark every actor that is safe or eliminated as removed
+void remove_actors(Global& global);
+
+// Round-end housekeeping: reclaim the actors removed during the round
+void finish_round(Global& global);
+
+CardProb competitor_prob(const CardCounts& counts, const Actor& actor);
+
+// Predict the odds of success and failure, reusing the last prediction while nothing has changed
+const Prediction& actor_predict(const CardCounts& counts, const Actor& actor);
+
+// Predict the odds of success
+float actor_predict_success(const CardCounts& counts, const Actor& actor);
+
+float actor_predict_fail(const CardCounts& counts, const Actor& actor);
+
+float actor_compete_will(const CardCounts& counts, const Actor& actor);
+
+// The compete will the actor would have after a trade that changes its hand by delta, the global counts
+// moving the other way. Worked out from the counts alone, without copying the actor or Global.
+float actor_compete_will_after(const CardCounts& counts, const Actor& actor, const CardDelta& delta);
+
+Card actor_compete(const CardCounts& counts, const Actor& actor);
+
+// The card actor plays against opponent: the lookahead's choice for an actor it controls, actor_compete's
+// otherwise
+Card npc_compete(const Global& global, const CardCounts& counts, const Actor& actor, const Actor& opponent);
+
+// The odds of each card being the one actor_compete plays, indexed by the card played
+CardProb actor_compete_odds(const CardCounts& counts, const Actor& actor);
+
+// Stars the first card wins against the second, indexed by [c1][c2]; the second card wins the opposite
+constexpr int8_t compete_outcomes[3][3] = {
+        // STONE, SCISSOR, PAPER
+        {0, 1, -1},  // STONE
+        {-1, 0, 1},  // SCISSOR
+        {1, -1, 0},  // PAPER
+};
+
+constexpr int single_compete(Card c1, Card c2) { return compete_outcomes[(int) c1][(int) c2]; }
+
+// Choose the cards of every pair as auto_compete does: in list order, with the thread's generator,
+// each pair seeing the counts left after the pairs before it. cards1/cards2 hold the first/second side.
+void choose_compete_cards(const Global& global, const HandleList& list,
+                          std::pmr::vector<uint8_t>& cards1, std::pmr::vector<uint8_t>& cards2);
+
+// Resolve count matches of cards1[i] against cards2[i] in one branch-free pass: stars1[i] gets the stars
+// the first side wins, and used[card] the number of cards of each kind played on both sides
+void resolve_matches(const uint8_t* cards1, const uint8_t* cards2, size_t count, int8_t* stars1, int used[3]);
+
+// Choose the cards, resolve the matches and apply the results to the actors and the global counts
+void auto_compete(Global& global, const HandleList& list);
+
+// auto_compete with the pairs split over a pool. Cards are chosen against the counts from the start
+// of the phase, and each match draws from a Philox stream keyed by (seed, round, pair index), so the
+// results do not depend on the number of threads. NPCs under global.lookahead choose by it instead.
+void auto_compete_parallel(Global& global, const HandleList& list, ThreadPool& pool,
+                           uint64_t seed, uint32_t round);
+
+// Every actor that can compete, sorted by will to compete. The sort-based reference for compete_top,
+// see compete_ranking.h; only the bench still uses it.
+HandleList compete_candidates(const Global& global);
+
+HandleList compete_list(const HandleList& candidates);
+
+// Whether this actor will receive the card
+bool can_receive_card(const Global& global, const Actor& actor, Card card);
+
+bool can_give_card(const Global& global, const Actor& actor, Card card);
+
+bool can_switch_card(const Global& global, const Actor& actor, Card from, Card to);
+
+// can_receive_card and can_give_card for all three cards in one call
+CardFlags receivable_cards(const Global& global, const Actor& actor);
+
+CardFlags givable_cards(const Global& global, const Actor& actor);
+
+void give_card(Actor& giver, Actor& receiver, Card card, bool verbose = false);
+
+// Let a pair of actors trade whatever cards both sides agree on; returns whether any card changed hands
+bool negotiate(const Global& global, Actor& a1, Actor& a2);
+
+// Negotiate every pair in the list, touching the actors that traded
+void auto_negotiate(Global& global, const HandleList& list);
+
+// auto_negotiate with the pairs split over a pool; gives exactly the same result
+void auto_negotiate_parallel(Global& global, const HandleList& list, ThreadPool& pool);
+
+// Every actor still in the game that is not in the compete list
+HandleList negotiate_candidates(const Global& global, const HandleList& compete_list);
+
+HandleList negotiate_list(const HandleList& candidates);
+
+#endif //ANIMAL_WORLD_GAME_H
@@ -0,0 +1,185 @@
+#ifndef ANIMAL_WORLD_GAME_PHASES_H
+#define ANIMAL_WORLD_GAME_PHASES_H
+
+#include "game.h"
+#include "strategy.h"
+#include "compete_ranking.h"
+#include "round_arena.h"
+#include "event_trace.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cassert>
+
+// The definitions of the round phases that strategy.h declares over a strategy. Include this header to play
+// by a strategy of your own. DefaultStrategy and Tournament are built once, in game.cpp and
+// compete_ranking.cpp, and the extern templates at the end keep every other file from building them again.
+
+// Trace one match between actors that have played their cards, stars1 being the stars a1 won
+inline void trace_match(const Actor& a1, const Actor& a2, Card c1, Card c2, int stars1) {
+    trace_event(EventType::MATCH_PLAYED, a1.id, a2.id, (uint8_t) c1, (uint8_t) c2, (int8_t) stars1);
+    trace_event(EventType::CARD_CONSUMED, a1.id, -1, (uint8_t) c1);
+    trace_event(EventType::CARD_CONSUMED, a2.id, -1, (uint8_t) c2);
+    if (stars1 > 0) trace_event(EventType::STAR_TRANSFERRED, a1.id, a2.id, no_card, no_card, (int8_t) stars1);
+    else if (stars1 < 0) trace_event(EventType::STAR_TRANSFERRED, a2.id, a1.id, no_card, no_card, (int8_t) -stars1);
+}
+
+template<typename Strategy>
+void choose_compete_cards(const Global& global, const HandleList& list, std::pmr::vector<uint8_t>& cards1,
+                          std::pmr::vector<uint8_t>& cards2, const Strategy& strategy) {
+    assert(list.size() % 2 == 0);
+    cards1.resize(list.size() / 2);
+    cards2.resize(list.size() / 2);
+
+    // A running copy of the counts stands in for the consume_card calls between matches
+    CardCounts running = global;
+    for (size_t pair = 0; pair < list.size() / 2; ++pair) {
+        const Actor& a1 = global.actors[list[2 * pair]];
+        const Actor& a2 = global.actors[list[2 * pair + 1]];
+
+        Card c1 = strategy.choose_card(global, running, a1, a2);
+        Card c2 = strategy.choose_card(global, running, a2, a1);
+        running.remove_card(c1);
+        running.remove_card(c2);
+
+        cards1[pair] = (uint8_t) c1;
+        cards2[pair] = (uint8_t) c2;
+    }
+}
+
+template<typename Strategy>
+void auto_compete(Global& global, const HandleList& list, const Strategy& strategy) {
+    PROFILE_PHASE(Phase::COMPETITION);
+    // Ensure that there are even competitors
+    assert(list.size() % 2 == 0);
+    size_t pair_count = list.size() / 2;
+
+    std::pmr::vector<uint8_t> cards1(round_resource()), cards2(round_resource());
+    choose_compete_cards(global, list, cards1, cards2, strategy);
+
+    std::pmr::vector<int8_t> stars1(pair_count, round_resource());
+    int used[3];
+    resolve_matches(cards1.data(), cards2.data(), pair_count, stars1.data(), used);
+
+    bool tracing = trace_channel() != nullptr;
+
+    for (size_t pair = 0; pair < pair_count; ++pair) {
+        Actor& a1 = global.actors[list[2 * pair]];
+        Actor& a2 = global.actors[list[2 * pair + 1]];
+
+        a1.remove_card((Card) cards1[pair]);
+        a2.remove_card((Card) cards2[pair]);
+        a1.star_count += stars1[pair];
+        a2.star_count -= stars1[pair];
+        global.touch(list[2 * pair]);
+        global.touch(list[2 * pair + 1]);
+        if (tracing) trace_match(a1, a2, (Card) cards1[pair], (Card) cards2[pair], stars1[pair]);
+    }
+
+    global.stone_count -= used[(int) Card::STONE];
+    global.scissor_count -= used[(int) Card::SCISSOR];
+    global.paper_count -= used[(int) Card::PAPER];
+}
+
+template<typename Strategy>
+HandleList compete_list(Global& global, const Strategy& strategy) {
+    HandleList list(round_resource());
+    {
+        PROFILE_PHASE(Phase::CANDIDATES);
+        global.refresh();
+
+        auto dist = std::uniform_int_distribution<int>(0, (int) global.eligible_count);
+        int rand = dist(generator);
+
+        // Ensure that we always take even candidates
+        if (rand % 2 == 1) --rand;
+
+        list = compete_top(global, rand);
+    }
+
+    // Actors may turn their places down, and the list must stay even
+    if (strategy.may_decline(global)) {
+        auto declined = std::remove_if(list.begin(), list.end(), [&](ActorHandle handle) {
+            return !strategy.will_compete(global, global.actors[handle]);
+        });
+        list.erase(declined, list.end());
+        if (list.size() % 2 == 1) list.pop_back();
+    }
+
+    PROFILE_PHASE(Phase::LISTS);
+    std::shuffle(list.begin(), list.end(), generator);
+    return list;
+}
+
+template<typename Strategy>
+bool negotiate(const Global& global, Actor& a1, Actor& a2, const Strategy& strategy) {
+    bool traded = false;
+
+    // Card by card, so that most checks are skipped; judging all three up front costs twice as much here
+    for (int i = 0; i < 3; ++i) {
+        Card card = (Card) i;
+        if (strategy.will_give(global, a1, card) && strategy.will_receive(global, a2, card))
+            give_card(a1, a2, card);
+        else if (strategy.will_give(global, a2, card) && strategy.will_receive(global, a1, card))
+            give_card(a2, a1, card);
+        else
+            continue;
+        traded = true;
+    }
+    return traded;
+}
+
+template<typename Strategy>
+void auto_negotiate(Global& global, const HandleList& list, const Strategy& strategy) {
+    PROFILE_PHASE(Phase::NEGOTIATION);
+    assert(list.size() % 2 == 0);
+
+    for (auto iter = list.begin(); iter != list.end(); iter += 2) {
+        if (negotiate(global, global.actors[*iter], global.actors[*(iter + 1)], strategy)) {
+            global.touch(*iter);
+            global.touch(*(iter + 1));
+        }
+    }
+}
+
+template<typename Strategy>
+void auto_negotiate_parallel(Global& global, const HandleList& list, ThreadPool& pool, const Strategy& strategy) {
+    PROFILE_PHASE(Phase::NEGOTIATION);
+    assert(list.size() % 2 == 0);
+    size_t pair_count = list.size() / 2;
+
+    // Pairs are disjoint and Global is only read, so the order they run in does not matter.
+    // Workers only flag the pairs that traded, since the round arena is not theirs to allocate from,
+    // and the flagged pairs are touched afterwards.
+    std::pmr::vector<uint8_t> traded(pair_count, 0, round_resource());
+    EventChannel* trace = trace_channel();
+    pool.parallel_for(pair_count, [&](size_t pair, int worker) {
+        TraceScope trace_scope(worker_trace_channel(trace, worker));
+        traded[pair] = negotiate(global, global.actors[list[2 * pair]], global.actors[list[2 * pair + 1]], strategy);
+    }, 256);
+
+    for (size_t pair = 0; pair < pair_count; ++pair) {
+        if (traded[pair]) {
+            global.touch(list[2 * pair]);
+            global.touch(list[2 * pair + 1]);
+        }
+    }
+}
+
+// Built in game.cpp and compete_ranking.cpp
+extern template void choose_compete_cards(const Global&, const HandleList&, std::pmr::vector<uint8_t>&,
+                                          std::pmr::vector<uint8_t>&, const DefaultStrategy&);
+extern template void auto_compete(Global&, const HandleList&, const DefaultStrategy&);
+extern template HandleList compete_list(Global&, const DefaultStrategy&);
+extern template bool negotiate(const Global&, Actor&, Actor&, const DefaultStrategy&);
+extern template void auto_negotiate(Global&, const HandleList&, const DefaultStrategy&);
+extern template void auto_negotiate_parallel(Global&, const HandleList&, ThreadPool&, const DefaultStrategy&);
+extern template void choose_compete_cards(const Global&, const HandleList&, std::pmr::vector<uint8_t>&,
+                                          std::pmr::vector<uint8_t>&, const Tournament&);
+extern template void auto_compete(Global&, const HandleList&, const Tournament&);
+extern template HandleList compete_list(Global&, const Tournament&);
+extern template bool negotiate(const Global&, Actor&, Actor&, const Tournament&);
+extern template void auto_negotiate(Global&, const HandleList&, const Tournament&);
+extern template void auto_negotiate_parallel(Global&, const HandleList&, ThreadPool&, const Tournament&);
+
+#endif //ANIMAL_WORLD_GAME_PHASES_H
@@ -0,0 +1,439 @@
+#include "hand_class.h"
+
+#include <algorithm>
+#include <map>
+#include <tuple>
+#include <cmath>
+#include <cassert>
+
+using std::vector;
+using std::map;
+
+// Populations keyed by hand; used to merge the classes that phases produce
+using ClassCounts = map<Hand, long long>;
+
+// A compete batch plays at most about 1/compete_batch_resolution of the cards left, so the odds
+// it is played with stay close to the ones the per-actor engine sees pair by pair
+static const long long compete_batch_resolution = 64;
+
+bool Hand::operator<(const Hand& other) const {
+    return std::tie(stone_count, scissor_count, paper_count, star_count) <
+           std::tie(other.stone_count, other.scissor_count, other.paper_count, other.star_count);
+}
+
+Actor Hand::actor() const {
+    return Actor{0, {}, stone_count, scissor_count, paper_count, star_count};
+}
+
+Hand Hand::of(const Actor& actor) {
+    return Hand{actor.stone_count, actor.scissor_count, actor.paper_count, actor.star_count};
+}
+
+ClassWorld::ClassWorld(long long actor_count, const Hand& hand) : global{no_actors} {
+    classes.push_back(HandClass{hand, actor_count});
+    global.stone_count = (int) (hand.stone_count * actor_count);
+    global.scissor_count = (int) (hand.scissor_count * actor_count);
+    global.paper_count = (int) (hand.paper_count * actor_count);
+}
+
+long long ClassWorld::population() const {
+    long long result = 0;
+    for (auto& hand_class : classes)
+        result += hand_class.population;
+    return result;
+}
+
+long long hypergeometric(long long good, long long bad, long long draws) {
+    long long total = good + bad;
+    assert(0 <= draws && draws <= total);
+
+    if (draws == 0 || good == 0) return 0;
+    if (bad == 0) return draws;
+    if (draws > total / 2) return good - hypergeometric(good, bad, total - draws);
+
+    // Few draws: make them one by one
+    if (draws <= 16) {
+        long long result = 0;
+        for (long long i = 0; i < draws; ++i) {
+            auto dist = std::uniform_int_distribution<long long>(0, total - 1);
+            if (dist(generator) < good) {
+                ++result;
+                --good;
+            }
+            --total;
+        }
+        return result;
+    }
+
+    // Otherwise use the ratio-of-uniforms method of Stadlober (HRUA), whose cost does not grow with the counts
+    long long small = std::min(good, bad);
+    long long large = std::max(good, bad);
+    double p = (double) small / (double) total;
+    double q = (double) large / (double) total;
+
+    double a = (double) draws * p + 0.5;
+    double c = std::sqrt((double) (total - draws) * (double) draws * p * q / (double) (total - 1) + 0.5);
+    double h = 1.7155277699214135 * c + 0.8989161620588988;
+    auto mode = (long long) ((double) (draws + 1) * (double) (small + 1) / (double) (total + 2));
+    double bound = std::min((double) std::min(draws, small) + 1, std::floor(a + 16 * c));
+
+    auto log_factorial = [](long long n) { return std::lgamma((double) n + 1); };
+    auto log_weight = [&](long long k) {
+        return log_factorial(k) + log_factorial(small - k) + log_factorial(draws - k) +
+               log_factorial(large - draws + k);
+    };
+    double mode_weight = log_weight(mode);
+
+    auto dist = std::uniform_real_distribution<double>(0, 1);
+    long long result;
+    while (true) {
+        double u = dist(generator);
+        double v = dist(generator);
+        if (u <= 0) continue;
+
+        double x = a + h * (v - 0.5) / u;
+        if (x < 0 || x >= bound) continue;
+
+        result = (long long) x;
+        double t = mode_weight - log_weight(result);
+        if (u * (4 - u) - 3 <= t) break;
+        if (u * (u - t) >= 1) continue;
+        if (2 * std::log(u) <= t) break;
+    }
+
+    return good > bad ? draws - result : result;
+}
+
+// Split `draws` items drawn without replacement across the populations
+static vector<long long> multivariate_hypergeometric(const vector<long long>& populations, long long draws) {
+    long long total = 0;
+    for (long long population : populations)
+        total += population;
+
+    vector<long long> result(populations.size());
+    for (size_t i = 0; i < populations.size() && draws > 0; ++i) {
+        total -= populations[i];
+        result[i] = hypergeometric(populations[i], total, draws);
+        draws -= result[i];
+    }
+    return result;
+}
+
+// Split `trials` across categories with the given odds
+static vector<long long> multinomial(const vector<double>& odds, long long trials) {
+    vector<long long> result(odds.size());
+    double mass = 1;
+
+    for (size_t i = 0; i < odds.size() && trials > 0; ++i) {
+        if (i + 1 == odds.size() || mass <= 0) {
+            result[i] = trials;
+            break;
+        }
+
+        double p = std::clamp(odds[i] / mass, 0.0, 1.0);
+        auto dist = std::binomial_distribution<long long>(trials, p);
+        result[i] = dist(generator);
+        trials -= result[i];
+        mass -= odds[i];
+    }
+    return result;
+}
+
+// Population weights that can be drawn from one unit at a time (a Fenwick tree)
+struct WeightTree {
+    std::vector<long long> tree;
+
+    explicit WeightTree(const vector<long long>& weights) : tree(weights.size() + 1) {
+        for (size_t i = 0; i < weights.size(); ++i)
+            add(i, weights[i]);
+    }
+
+    void add(size_t index, long long delta) {
+        for (size_t i = index + 1; i < tree.size(); i += i & (~i + 1))
+            tree[i] += delta;
+    }
+
+    // The index holding the rank-th unit of weight, counting from zero
+    [[nodiscard]] size_t find(long long rank) const {
+        size_t index = 0;
+        size_t step = 1;
+        while (step * 2 < tree.size()) step *= 2;
+
+        for (; step > 0; step /= 2) {
+            if (index + step < tree.size() && tree[index + step] <= rank) {
+                index += step;
+                rank -= tree[index];
+            }
+        }
+        return index;
+    }
+};
+
+// How many pairs have their first actor from class `first` and their second from class `second`
+struct PairCount {
+    size_t first;
+    size_t second;
+    long long count;
+};
+
+// Shuffle the actors and pair them up in order, as compete_list/negotiate_list do
+static vector<PairCount> random_pairs(const vector<long long>& populations) {
+    long long total = 0;
+    for (long long population : populations)
+        total += population;
+    assert(total % 2 == 0);
+
+    // The first halves of all pairs are a random subset; the second halves are matched to them at random
+    auto firsts = multivariate_hypergeometric(populations, total / 2);
+    vector<long long> seconds(populations.size());
+    for (size_t i = 0; i < populations.size(); ++i)
+        seconds[i] = populations[i] - firsts[i];
+
+    WeightTree tree(seconds);
+    long long second_total = total / 2;
+
+    vector<PairCount> pairs;
+    vector<size_t> partners;
+    for (size_t i = 0; i < populations.size(); ++i) {
+        if (firsts[i] == 0) continue;
+
+        if (firsts[i] * 16 < (long long) populations.size()) {
+            // A few actors: draw their partners one by one
+            partners.clear();
+            for (long long k = 0; k < firsts[i]; ++k) {
+                auto dist = std::uniform_int_distribution<long long>(0, second_total - 1);
+                size_t j = tree.find(dist(generator));
+                tree.add(j, -1);
+                --seconds[j];
+                --second_total;
+                partners.push_back(j);
+            }
+
+            std::sort(partners.begin(), partners.end());
+            for (size_t k = 0; k < partners.size(); ++k) {
+                if (k > 0 && partners[k] == partners[k - 1]) ++pairs.back().count;
+                else pairs.push_back(PairCount{i, partners[k], 1});
+            }
+        } else {
+            // Many actors: split them across all classes at once
+            auto row = multivariate_hypergeometric(seconds, firsts[i]);
+            for (size_t j = 0; j < populations.size(); ++j) {
+                if (row[j] == 0) continue;
+                tree.add(j, -row[j]);
+                seconds[j] -= row[j];
+                pairs.push_back(PairCount{i, j, row[j]});
+            }
+            second_total -= firsts[i];
+        }
+    }
+    return pairs;
+}
+
+static void add_population(ClassCounts& counts, const Hand& hand, long long population) {
+    if (population > 0) counts[hand] += population;
+}
+
+static void remove_classes(ClassWorld& world, ClassCounts& counts) {
+    for (auto iter = counts.begin(); iter != counts.end();) {
+        auto actor = iter->first.actor();
+        auto result = check_actor(world.global, actor);
+
+        if (result == CheckResult::CONTINUE) {
+            ++iter;
+            continue;
+        }
+
+        if (result == CheckResult::WIN) world.safe_count += iter->second;
+        else world.eliminated_count += iter->second;
+        iter = counts.erase(iter);
+    }
+}
+
+// Compete phase: returns the hands of the competitors afterwards; everyone else ends up in idle
+static ClassCounts compete_classes(ClassWorld& world, ClassCounts& idle) {
+    auto& global = world.global;
+
+    // CompeteRanking: every class that can compete, by descending will
+    vector<std::pair<float, HandClass>> candidates;
+    long long candidate_count = 0;
+    for (auto& hand_class : world.classes) {
+        auto actor = hand_class.hand.actor();
+        if (actor.can_compete()) {
+            candidates.emplace_back(actor_compete_will(global, actor), hand_class);
+            candidate_count += hand_class.population;
+        } else
+            add_population(idle, hand_class.hand, hand_class.population);
+    }
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [](auto& c1, auto& c2) { return c1.first > c2.first; });
+
+    // compete_list: a random even-sized prefix of the candidates
+    auto dist = std::uniform_int_distribution<long long>(0, candidate_count);
+    long long remaining = dist(generator);
+    if (remaining % 2 == 1) --remaining;
+
+    // Hands of equal will share a rank, so the cut through them is made at random
+    vector<long long> taken(candidates.size());
+    for (size_t begin = 0, end; begin < candidates.size(); begin = end) {
+        vector<long long> tied;
+        long long tied_count = 0;
+        for (end = begin; end < candidates.size() && candidates[end].first == candidates[begin].first; ++end) {
+            tied.push_back(candidates[end].second.population);
+            tied_count += candidates[end].second.population;
+        }
+
+        long long draws = std::min(remaining, tied_count);
+        auto tied_taken = multivariate_hypergeometric(tied, draws);
+        remaining -= draws;
+
+        for (size_t i = begin; i < end; ++i) {
+            auto& hand_class = candidates[i].second;
+            taken[i] = tied_taken[i - begin];
+            add_population(idle, hand_class.hand, hand_class.population - taken[i]);
+        }
+    }
+
+    // auto_compete: the shuffled list is played in order, so any run of consecutive pairs is a random
+    // subset of the competitors, paired at random. The phase is resolved in batches of such runs, and
+    // the global counts are brought up to date between batches like the per-actor engine does between
+    // pairs. Both sides of a match pick their card the same way, so a batch only has to know which
+    // cards were played and how those cards met, not which classes met.
+    long long pair_total = 0;
+    for (long long count : taken)
+        pair_total += count;
+    pair_total /= 2;
+
+    long long card_total = std::max(global.total_count(), 1);
+    long long batch_count = (2 * pair_total * compete_batch_resolution + card_total - 1) / card_total;
+    batch_count = std::min(pair_total, std::max(batch_count, 1LL));
+
+    ClassCounts competed;
+    vector<vector<long long>> played(candidates.size());
+
+    for (long long batch = 0; batch < batch_count; ++batch) {
+        long long batch_size = pair_total / (batch_count - batch);
+        pair_total -= batch_size;
+
+        auto members = multivariate_hypergeometric(taken, 2 * batch_size);
+
+        // Which cards each class plays
+        vector<long long> card_counts(3);
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            played[i].assign(3, 0);
+            if (members[i] == 0) continue;
+            taken[i] -= members[i];
+
+            auto odds = actor_compete_odds(global, candidates[i].second.hand.actor());
+            played[i] = multinomial({odds[Card::STONE], odds[Card::SCISSOR], odds[Card::PAPER]}, members[i]);
+            for (int c = 0; c < 3; ++c)
+                card_counts[c] += played[i][c];
+        }
+
+        // How many players of card c met a player of card d
+        vector<vector<long long>> met(3, vector<long long>(3));
+        for (auto& pair : random_pairs(card_counts)) {
+            met[pair.first][pair.second] += pair.count;
+            met[pair.second][pair.first] += pair.count;
+        }
+
+        // Share out those meetings among the classes that played each card
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            for (int c = 0; c < 3; ++c) {
+                if (played[i][c] == 0) continue;
+
+                auto opponents = multivariate_hypergeometric(met[c], played[i][c]);
+                for (int d = 0; d < 3; ++d) {
+                    if (opponents[d] == 0) continue;
+                    met[c][d] -= opponents[d];
+
+                    auto actor = candidates[i].second.hand.actor();
+                    actor.remove_card((Card) c);
+                    actor.star_count += single_compete((Card) c, (Card) d);
+                    add_population(competed, Hand::of(actor), opponents[d]);
+                }
+            }
+        }
+
+        global.stone_count -= (int) card_counts[(int) Card::STONE];
+        global.scissor_count -= (int) card_counts[(int) Card::SCISSOR];
+        global.paper_count -= (int) card_counts[(int) Card::PAPER];
+    }
+
+    return competed;
+}
+
+// Negotiate phase on the actors that sat out the competition
+static ClassCounts negotiate_classes(ClassWorld& world, const ClassCounts& idle) {
+    vector<Hand> hands;
+    vector<long long> populations;
+    long long total = 0;
+    for (auto& [hand, population] : idle) {
+        hands.push_back(hand);
+        populations.push_back(population);
+        total += population;
+    }
+
+    ClassCounts negotiated;
+
+    // negotiate_list leaves one actor out when the count is odd
+    if (total % 2 == 1) {
+        auto dist = std::uniform_int_distribution<long long>(0, total - 1);
+        long long pick = dist(generator);
+        for (size_t i = 0; i < populations.size(); ++i) {
+            if (pick < populations[i]) {
+                --populations[i];
+                add_population(negotiated, hands[i], 1);
+                break;
+            }
+            pick -= populations[i];
+        }
+    }
+
+    // auto_negotiate is deterministic, so every pair of the same two hands ends up the same way
+    for (auto& pair : random_pairs(populations)) {
+        auto a1 = hands[pair.first].actor();
+        auto a2 = hands[pair.second].actor();
+        negotiate(world.global, a1, a2);
+
+        add_population(negotiated, Hand::of(a1), pair.count);
+        add_population(negotiated, Hand::of(a2), pair.count);
+    }
+    return negotiated;
+}
+
+void hand_class_round(ClassWorld& world) {
+    ClassCounts idle;
+    auto competed = compete_classes(world, idle);
+
+    remove_classes(world, competed);
+    remove_classes(world, idle);
+
+    auto negotiated = negotiate_classes(world, idle);
+
+    for (auto& [hand, population] : negotiated)
+        competed[hand] += population;
+
+    world.classes.clear();
+    for (auto& [hand, population] : competed)
+        world.classes.push_back(HandClass{hand, population});
+}
+
+GameResult simulate_hand_class_game(const SimulationConfig& config, unsigned seed,
+                                    vector<long long>* eliminated_by_round) {
+    generator.seed(seed);
+
+    auto& rules = config.rules;
+    ClassWorld world(config.actor_count, Hand{rules.stone_count, rules.scissor_count, rules.paper_count,
+                                              rules.star_count});
+    world.global.rules = rules;
+    for (int round = 0; round < config.round_count && !world.classes.empty(); ++round) {
+        long long eliminated_before = world.eliminated_count;
+        hand_class_round(world);
+        if (eliminated_by_round != nullptr) {
+            if ((int) eliminated_by_round->size() <= round) eliminated_by_round->resize(round + 1);
+            (*eliminated_by_round)[round] += world.eliminated_count - eliminated_before;
+        }
+    }
+
+    return GameResult{(int) world.safe_count, (int) world.eliminated_count, (int) world.population()};
+}
@@ -0,0 +1,61 @@
+#ifndef ANIMAL_WORLD_HAND_CLASS_H
+#define ANIMAL_WORLD_HAND_CLASS_H
+
+#include "game.h"
+#include "simulate.h"
+
+#include <vector>
+
+// Everything the AI of an actor depends on besides the global counts
+struct Hand {
+    int stone_count;
+    int scissor_count;
+    int paper_count;
+    int star_count;
+
+    bool operator<(const Hand& other) const;
+
+    // A nameless actor holding this hand
+    [[nodiscard]] Actor actor() const;
+
+    static Hand of(const Actor& actor);
+};
+
+// All actors sharing one hand, counted instead of stored
+struct HandClass {
+    Hand hand;
+    long long population;
+};
+
+// A world of counted actors. Phases run on class populations and draw outcomes for a whole
+// class at once, so the cost of a round depends on the number of distinct hands, not actors.
+struct ClassWorld {
+    // Global needs somewhere to point at; the actors themselves are never materialized
+    ActorRegistry no_actors;
+    Global global;
+
+    std::vector<HandClass> classes;
+
+    long long safe_count = 0;
+    long long eliminated_count = 0;
+
+    ClassWorld(long long actor_count, const Hand& hand);
+
+    ClassWorld(const ClassWorld&) = delete;
+
+    ClassWorld& operator=(const ClassWorld&) = delete;
+
+    [[nodiscard]] long long population() const;
+};
+
+// The number of good items among `draws` drawn without replacement, using the thread's generator
+long long hypergeometric(long long good, long long bad, long long draws);
+
+// Play compete_list, auto_compete, remove_actors and auto_negotiate on class counts
+void hand_class_round(ClassWorld& world);
+
+// The counterpart of simulate_game on the hand-class engine
+GameResult simulate_hand_class_game(const SimulationConfig& config, unsigned seed,
+                                    std::vector<long long>* eliminated_by_round = nullptr);
+
+#endif //ANIMAL_WORLD_HAND_CLASS_H
@@ -0,0 +1,322 @@
+#include "lookahead.h"
+#include "philox.h"
+
+#include <iostream>
+#include <algorithm>
+
+using std::cout;
+using std::endl;
+
+using Clock = std::chrono::steady_clock;
+
+// A rollout's first round, counted from the decision
+enum class FirstRound {
+    // Drawn to compete by the actor's odds, as in any later round
+    FREE,
+    COMPETE,
+    SIT_OUT,
+    // The decision is taken after the compete phase, so the rollout starts with the next round
+    NEXT,
+};
+
+struct RolloutStart {
+    int hand[3];
+    int stars;
+
+    // The cards everyone else holds, by kind, and how many of them they play in a round
+    float others[3];
+    float others_played;
+
+    // The chance of a place in the compete list
+    float compete_chance;
+
+    int rounds_left;
+    Rules rules;
+};
+
+struct RolloutOption {
+    FirstRound first = FirstRound::FREE;
+
+    // The card played when competing in the first round; -1 leaves it to the heuristic
+    int card = -1;
+
+    // The odds of each card of a known opponent in the first round; the pool's when not known
+    bool opponent_known = false;
+    CardProb opponent_odds;
+
+    // A trade before the first round, the pool changing the other way
+    CardDelta trade;
+};
+
+// The card a draw of unit lands on, by weights
+static int pick(const float weights[3], float unit) {
+    float sum = weights[0] + weights[1] + weights[2];
+    float rand = unit * sum;
+    if (rand < weights[0]) return 0;
+    if (rand < weights[0] + weights[1] || weights[2] <= 0) return weights[1] > 0 ? 1 : 0;
+    return 2;
+}
+
+// The card the heuristic plays: one of the actor's cards, weighted by the odds of meeting the card it beats,
+// as actor_compete does
+static int heuristic_card(const int hand[3], const float others[3], float unit) {
+    float weights[3] = {0, 0, 0};
+    for (int card = 0; card < 3; ++card) {
+        if (hand[card] <= 0) continue;
+        // The card this one beats is the next one, cyclically
+        weights[card] = others[(card + 1) % 3];
+    }
+
+    if (weights[0] + weights[1] + weights[2] <= 0) {
+        // Nothing to beat; settle on the first card held, in the heuristic's order
+        for (int card : {(int) Card::PAPER, (int) Card::STONE, (int) Card::SCISSOR})
+            if (hand[card] > 0) return card;
+    }
+    return pick(weights, unit);
+}
+
+// Play rollout index of an option to the end; true when the actor ends safe
+static bool play_rollout(const RolloutStart& start, const RolloutOption& option, const Philox& philox,
+                         uint32_t index) {
+    int hand[3] = {start.hand[0] + option.trade.values[0], start.hand[1] + option.trade.values[1],
+                   start.hand[2] + option.trade.values[2]};
+    float others[3] = {std::max(0.0f, start.others[0] - (float) option.trade.values[0]),
+                       std::max(0.0f, start.others[1] - (float) option.trade.values[1]),
+                       std::max(0.0f, start.others[2] - (float) option.trade.values[2])};
+    int stars = start.stars;
+    auto& rules = start.rules;
+
+    int round = 0;
+    int rounds_left = start.rounds_left;
+    if (option.first == FirstRound::NEXT) --rounds_left;
+
+    for (; rounds_left > 0; ++round, --rounds_left) {
+        auto draw = philox({index, (uint32_t) round, 0, 0});
+        bool first = round == 0 && option.first != FirstRound::NEXT;
+        int card_count = hand[0] + hand[1] + hand[2];
+
+        bool competes = card_count > 0 && others[0] + others[1] + others[2] >= 1;
+        if (first && option.first == FirstRound::SIT_OUT) competes = false;
+        else if (!(first && option.first == FirstRound::COMPETE))
+            competes = competes && Philox::unit(draw[0]) < start.compete_chance;
+
+        if (competes) {
+            int card = first && option.card >= 0 ? option.card
+                                                 : heuristic_card(hand, others, Philox::unit(draw[1]));
+            const float* other_odds = first && option.opponent_known ? option.opponent_odds.values : others;
+            int other_card = pick(other_odds, Philox::unit(draw[2]));
+            stars += single_compete((Card) card, (Card) other_card);
+            --hand[card];
+            others[other_card] = std::max(0.0f, others[other_card] - 1);
+        }
+
+        float other_total = others[0] + others[1] + others[2];
+        if (other_total > 0) {
+            float kept = std::max(0.0f, 1 - start.others_played / other_total);
+            for (float& count : others)
+                count *= kept;
+        }
+
+        if (stars >= rules.safe_star_count && hand[0] + hand[1] + hand[2] <= 0) return true;
+        if (stars <= rules.eliminated_star_count) return false;
+
+        // The heuristic gives any card away once the stars are there, and a taker is found about half the time
+        if (!competes && stars >= rules.safe_star_count && Philox::unit(draw[3]) < 0.5f) {
+            float held[3] = {(float) hand[0], (float) hand[1], (float) hand[2]};
+            int card = pick(held, Philox::unit(draw[3]) * 2);
+            --hand[card];
+            others[card] += 1;
+        }
+    }
+
+    // Past the last round the actor is no better off than eliminated
+    return false;
+}
+
+Lookahead::Lookahead(const LookaheadConfig& config) : config{config}, pool{config.thread_count} {}
+
+// What the actor starts a rollout from, with counts the cards in play
+static RolloutStart rollout_start(const Global& global, const CardCounts& counts, const Actor& actor,
+                                  int round_count) {
+    RolloutStart start{};
+    start.hand[(int) Card::STONE] = actor.stone_count;
+    start.hand[(int) Card::SCISSOR] = actor.scissor_count;
+    start.hand[(int) Card::PAPER] = actor.paper_count;
+    start.stars = actor.star_count;
+    start.others[(int) Card::STONE] = (float) std::max(0, counts.stone_count - actor.stone_count);
+    start.others[(int) Card::SCISSOR] = (float) std::max(0, counts.scissor_count - actor.scissor_count);
+    start.others[(int) Card::PAPER] = (float) std::max(0, counts.paper_count - actor.paper_count);
+    start.rounds_left = round_count - global.round;
+    start.rules = global.rules;
+
+    // The compete list is an even prefix of a uniform length of the ranking by will, so an actor ranked at
+    // fraction f of the way down it is in the list with odds 1 - f. Hands share a will, so the ranking is
+    // read off the buckets. Eligible actors play about half of them a round, one card each.
+    float will = actor_compete_will(counts, actor);
+    long long ahead = 0, level = 0, eligible = 0;
+    for (auto& bucket : global.hand_buckets) {
+        if (bucket.members.empty()) continue;
+        Actor hand{};
+        hand.stone_count = (int) (bucket.key & 0x3ff);
+        hand.scissor_count = (int) (bucket.key >> 10 & 0x3ff);
+        hand.paper_count = (int) (bucket.key >> 20 & 0x3ff);
+        float other_will = actor_compete_will(counts, hand);
+        auto size = (long long) bucket.members.size();
+        eligible += size;
+        if (other_will > will) ahead += size;
+        else if (other_will == will) level += size;
+    }
+    if (eligible > 0) {
+        start.compete_chance = 1 - ((float) ahead + (float) level / 2) / (float) eligible;
+        start.others_played = (float) eligible / 2;
+    }
+    return start;
+}
+
+// What a decision is about, for its key
+enum class Decision : uint32_t {
+    CARD,
+    COMPETE,
+    TRADE,
+};
+
+// The key of a decision's streams, mixed from the game's seed, the round, the actor, and the decision and its
+// subject. Decisions are made on whichever thread plays the phase, so the key comes from what they are about,
+// as the streams of auto_compete_parallel do, and never from a thread's generator.
+static uint64_t decision_key(const Global& global, const Actor& actor, Decision decision, uint32_t subject) {
+    uint64_t key = global.seed;
+    for (uint64_t word : {(uint64_t) (uint32_t) global.round, (uint64_t) decision, (uint64_t) (uint32_t) actor.id,
+                          (uint64_t) subject}) {
+        // A splitmix64 step over each word in turn
+        key = (key ^ word) + 0x9E3779B97F4A7C15;
+        key = (key ^ (key >> 30)) * 0xBF58476D1CE4E5B9;
+        key = (key ^ (key >> 27)) * 0x94D049BB133111EB;
+        key ^= key >> 31;
+    }
+    return key;
+}
+
+bool Lookahead::evaluate(const RolloutStart& start, const RolloutOption* options, int option_count,
+                         uint64_t key, long long* wins) {
+    auto begin = Clock::now();
+    auto deadline = begin + config.budget;
+    bool timed = config.budget.count() > 0;
+
+    Philox philox(key);
+
+    std::atomic<int> next_index{0};
+    std::atomic<long long> played{0};
+    std::mutex wins_mutex;
+    std::fill(wins, wins + option_count, 0);
+
+    auto play = [&]() {
+        long long local_wins[8] = {};
+        long long local_played = 0;
+        while (true) {
+            int index = next_index.fetch_add(1, std::memory_order_relaxed);
+            if (index >= config.max_rollouts) break;
+            if (timed && Clock::now() >= deadline) break;
+
+            for (int option = 0; option < option_count; ++option)
+                local_wins[option] += play_rollout(start, options[option], philox, (uint32_t) index);
+            ++local_played;
+        }
+
+        played += local_played;
+        std::lock_guard<std::mutex> lock(wins_mutex);
+        for (int option = 0; option < option_count; ++option)
+            wins[option] += local_wins[option];
+    };
+
+    std::unique_lock<std::mutex> lock(pool_mutex, std::try_to_lock);
+    if (lock.owns_lock() && pool.size() > 1) pool.parallel_for(pool.size(), [&](size_t, int) { play(); });
+    else play();
+
+    ++decision_count;
+    rollout_count += played;
+    if (played < config.max_rollouts) ++cut_count;
+    nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin).count();
+    return played > 0;
+}
+
+// The card the heuristic would play, drawn by actor_compete's odds from the decision's own stream rather than
+// the thread's generator. Rollouts keep the third counter word at zero, so this draw is apart from theirs.
+static Card heuristic_choice(const CardCounts& counts, const Actor& actor, uint64_t key) {
+    auto odds = actor_compete_odds(counts, actor);
+    auto draw = Philox(key)({0, 0, 1, 0});
+    return (Card) pick(odds.values, Philox::unit(draw[0]));
+}
+
+Card Lookahead::choose_card(const Global& global, const CardCounts& counts, const Actor& actor,
+                            const Actor& opponent) {
+    RolloutOption options[3];
+    Card cards[3];
+    int option_count = 0;
+    for (int i = 0; i < 3; ++i) {
+        if (actor.card_count((Card) i) <= 0) continue;
+        cards[option_count] = (Card) i;
+        auto& option = options[option_count++];
+        option.first = FirstRound::COMPETE;
+        option.card = i;
+        option.opponent_known = true;
+        option.opponent_odds = actor_compete_odds(counts, opponent);
+    }
+    if (option_count == 1) return cards[0];
+
+    long long wins[3];
+    auto start = rollout_start(global, counts, actor, config.round_count);
+    auto key = decision_key(global, actor, Decision::CARD, (uint32_t) opponent.id);
+    if (!evaluate(start, options, option_count, key, wins)) return heuristic_choice(counts, actor, key);
+
+    int best = (int) (std::max_element(wins, wins + option_count) - wins);
+    // Nothing to tell the cards apart; leave it to the heuristic
+    if (*std::min_element(wins, wins + option_count) == wins[best]) return heuristic_choice(counts, actor, key);
+    return cards[best];
+}
+
+bool Lookahead::will_compete(const Global& global, const Actor& actor) {
+    RolloutOption options[2];
+    options[0].first = FirstRound::COMPETE;
+    options[1].first = FirstRound::SIT_OUT;
+
+    long long wins[2];
+    auto start = rollout_start(global, global, actor, config.round_count);
+    if (!evaluate(start, options, 2, decision_key(global, actor, Decision::COMPETE, 0), wins)) return true;
+    return wins[0] >= wins[1];
+}
+
+bool Lookahead::will_trade(const Global& global, const Actor& actor, const CardDelta& delta) {
+    for (int i = 0; i < 3; ++i)
+        if (actor.card_count((Card) i) + delta.values[i] < 0) return false;
+
+    RolloutOption options[2];
+    options[0].first = FirstRound::NEXT;
+    options[1].first = FirstRound::NEXT;
+    options[1].trade = delta;
+
+    long long wins[2];
+    auto start = rollout_start(global, global, actor, config.round_count);
+    // Each card count moves by a little, so a byte of each tells trades apart
+    uint32_t subject = 0;
+    for (int value : delta.values)
+        subject = subject << 8 | (uint8_t) value;
+    if (!evaluate(start, options, 2, decision_key(global, actor, Decision::TRADE, subject), wins)) return false;
+    return wins[1] >= wins[0];
+}
+
+LookaheadStats Lookahead::stats() const {
+    LookaheadStats result;
+    result.decision_count = decision_count;
+    result.rollout_count = rollout_count;
+    result.cut_count = cut_count;
+    result.seconds = (double) nanoseconds * 1e-9;
+    return result;
+}
+
+void display_lookahead_stats(const LookaheadStats& stats) {
+    double decisions = stats.decision_count > 0 ? (double) stats.decision_count : 1;
+    cout << "Lookahead decisions: " << stats.decision_count << endl;
+    cout << "Rollouts per decision: " << (double) stats.rollout_count / decisions << endl;
+    cout << "Time per decision: " << stats.seconds / decisions * 1e6 << " us" << endl;
+    cout << "Cut short by the budget: " << stats.cut_count << endl;
+}
@@ -0,0 +1,101 @@
+#ifndef ANIMAL_WORLD_LOOKAHEAD_H
+#define ANIMAL_WORLD_LOOKAHEAD_H
+
+#include "game.h"
+#include "thread_pool.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <cstdint>
+
+struct LookaheadConfig {
+    // NPCs with ids 1 to actor_count decide by lookahead, and the rest by the game's heuristic
+    int actor_count = 0;
+
+    // Rounds in a game, so that rollouts end where the game does
+    int round_count = 20;
+
+    // Wall-clock time a decision may take, after which it goes with the rollouts played so far. Zero plays
+    // every one of max_rollouts, so that decisions depend on the game's seed alone, on any number of threads.
+    std::chrono::microseconds budget{2000};
+
+    // Rollouts played for each option of a decision, at most
+    int max_rollouts = 1024;
+
+    // Zero means one thread per hardware thread
+    int thread_count = 0;
+};
+
+// What a rollout starts from, and how it plays its first round; see lookahead.cpp
+struct RolloutStart;
+struct RolloutOption;
+
+// What the decisions so far have taken
+struct LookaheadStats {
+    long long decision_count = 0;
+    long long rollout_count = 0;
+    // Decisions that ran out of time before playing max_rollouts
+    long long cut_count = 0;
+    double seconds = 0;
+};
+
+// NPC decisions made by playing every option out many times and taking the one that ends safe most often.
+//
+// A rollout starts from what the actor knows: its hand and stars, the cards everyone else holds, how likely
+// its will puts it in the compete list, and the rounds left. The others are played as that pool of cards:
+// when the actor competes it meets a card drawn from the pool, the others wear the pool down by the cards
+// they play, and an actor with the stars to be safe gets rid of a spare card in about half of the rounds it
+// sits out. Past its first round, the actor plays by the game's heuristic. This costs a few hundred
+// nanoseconds a rollout, where copying the world and playing it out would cost a whole game.
+//
+// Rollout i of a decision draws from its own Philox stream, and every option replays the same streams, so
+// options are compared on the same luck and the rollouts can be split over threads in any way. The streams
+// are keyed by the game's seed, the round, the actor and what is decided, so a decision comes out the same
+// on whichever thread makes it, and draws nothing from the thread's generator.
+//
+// One instance serves any number of games on any number of threads. A decision takes the instance's pool when
+// it is free and plays its rollouts on the calling thread otherwise, always within the budget.
+class Lookahead {
+public:
+    explicit Lookahead(const LookaheadConfig& config);
+
+    Lookahead(const Lookahead&) = delete;
+
+    Lookahead& operator=(const Lookahead&) = delete;
+
+    [[nodiscard]] bool controls(const Actor& actor) const { return actor.id > 0 && actor.id <= config.actor_count; }
+
+    // The card to play against opponent, counts being the cards still in play
+    Card choose_card(const Global& global, const CardCounts& counts, const Actor& actor, const Actor& opponent);
+
+    // Whether to keep a place drawn in the compete list
+    bool will_compete(const Global& global, const Actor& actor);
+
+    // Whether to take a trade that changes the actor's hand by delta
+    bool will_trade(const Global& global, const Actor& actor, const CardDelta& delta);
+
+    [[nodiscard]] LookaheadStats stats() const;
+
+    [[nodiscard]] const LookaheadConfig& settings() const { return config; }
+
+private:
+    // The number of rollouts, out of those played, in which each option ended safe; false when none was played.
+    // key keys the rollouts' streams.
+    bool evaluate(const RolloutStart& start, const RolloutOption* options, int option_count, uint64_t key,
+                  long long* wins);
+
+    LookaheadConfig config;
+
+    std::mutex pool_mutex;
+    ThreadPool pool;
+
+    std::atomic<long long> decision_count{0};
+    std::atomic<long long> rollout_count{0};
+    std::atomic<long long> cut_count{0};
+    std::atomic<long long> nanoseconds{0};
+};
+
+void display_lookahead_stats(const LookaheadStats& stats);
+
+#endif //ANIMAL_WORLD_LOOKAHEAD_H
@@ -0,0 +1,80 @@
+#include "mapped_file.h"
+
+#include <fstream>
+#include <sstream>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define ANIMAL_WORLD_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string& filename) {
+#ifdef ANIMAL_WORLD_MMAP
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        struct stat status{};
+        if (fstat(fd, &status) == 0) {
+            length = (size_t) status.st_size;
+            opened = true;
+
+            // Mapping an empty file fails, and there is nothing to map anyway
+            if (length > 0) {
+                void* address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (address != MAP_FAILED) {
+                    bytes = (const char*) address;
+                    mapped = true;
+                } else
+                    opened = false;
+            }
+        }
+        ::close(fd);
+        if (opened) return;
+    }
+#endif
+
+    std::ifstream fs{filename, std::ios::binary};
+    if (!fs) return;
+
+    std::ostringstream contents;
+    contents << fs.rdbuf();
+    buffer = contents.str();
+    bytes = buffer.data();
+    length = buffer.size();
+    opened = true;
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this == &other) return *this;
+    close();
+
+    opened = std::exchange(other.opened, false);
+    mapped = std::exchange(other.mapped, false);
+    length = std::exchange(other.length, 0);
+    buffer = std::move(other.buffer);
+    bytes = mapped ? other.bytes : buffer.data();
+    other.bytes = nullptr;
+    return *this;
+}
+
+void MappedFile::close() {
+#ifdef ANIMAL_WORLD_MMAP
+    if (mapped) munmap((void*) bytes, length);
+#endif
+    opened = false;
+    mapped = false;
+    bytes = nullptr;
+    length = 0;
+    buffer.clear();
+}
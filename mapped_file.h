@@ -0,0 +1,42 @@
+#ifndef ANIMAL_WORLD_MAPPED_FILE_H
+#define ANIMAL_WORLD_MAPPED_FILE_H
+
+#include <string>
+#include <cstddef>
+
+// A whole file viewed read-only in memory: mapped on POSIX systems, read in one go elsewhere
+class MappedFile {
+public:
+    MappedFile() = default;
+
+    explicit MappedFile(const std::string& filename);
+
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    MappedFile(const MappedFile&) = delete;
+
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    [[nodiscard]] bool is_open() const { return opened; }
+
+    [[nodiscard]] const char* data() const { return bytes; }
+
+    [[nodiscard]] size_t size() const { return length; }
+
+private:
+    void close();
+
+    bool opened = false;
+    bool mapped = false;
+    const char* bytes = nullptr;
+    size_t length = 0;
+
+    // Holds the contents when the file could not be mapped
+    std::string buffer;
+};
+
+#endif //ANIMAL_WORLD_MAPPED_FILE_H
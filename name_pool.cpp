@@ -0,0 +1,174 @@
+#include "name_pool.h"
+#include "game.h"
+
+#include <fstream>
+#include <algorithm>
+#include <numeric>
+#include <unordered_set>
+#include <cstring>
+#include <cassert>
+
+using std::vector;
+using std::string;
+using std::string_view;
+
+// Layout of <file>.idx: this header, then line_count + 1 line starts
+struct NameIndexHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t file_size;
+    uint64_t line_count;
+};
+
+static const char name_index_magic[4] = {'A', 'W', 'N', 'I'};
+static const uint32_t name_index_version = 1;
+
+NamePool::NamePool(const string& filename) : filename{filename}, file{filename} {
+    // Offsets are 32-bit; larger files are not supported
+    if (file.size() > UINT32_MAX) file = MappedFile();
+
+    if (!load_index()) {
+        line_starts.assign(1, 0);
+        scanned = 0;
+        complete = file.size() == 0;
+    }
+}
+
+size_t NamePool::size() const {
+    while (index_through(line_starts.size() - 1));
+    return line_starts.size() - 1;
+}
+
+string_view NamePool::operator[](size_t index) const {
+    bool found = index_through(index);
+    assert(found);
+    (void) found;
+
+    size_t begin = line_starts[index];
+    size_t end = line_starts[index + 1] - 1;
+    if (end > begin && file.data()[end - 1] == '\r') --end;
+    return string_view{file.data() + begin, end - begin};
+}
+
+vector<string_view> NamePool::first(size_t count) const {
+    vector<string_view> names;
+    for (size_t i = 0; i < count && index_through(i); ++i)
+        names.push_back((*this)[i]);
+    return names;
+}
+
+vector<string_view> NamePool::sample(size_t count) const {
+    size_t pool_size = size();
+    vector<string_view> names;
+    if (pool_size == 0) return names;
+    names.reserve(count);
+
+    vector<size_t> picks;
+    while (names.size() < count) {
+        size_t wanted = std::min(count - names.size(), pool_size);
+        picks.clear();
+
+        if (wanted * 2 > pool_size) {
+            // Most of the pool: a partial shuffle of every index
+            picks.resize(pool_size);
+            std::iota(picks.begin(), picks.end(), 0);
+            for (size_t i = 0; i < wanted; ++i) {
+                auto dist = std::uniform_int_distribution<size_t>(i, pool_size - 1);
+                std::swap(picks[i], picks[dist(generator)]);
+            }
+            picks.resize(wanted);
+        } else {
+            // A small part of the pool: Floyd's algorithm only touches what it picks
+            std::unordered_set<size_t> chosen;
+            for (size_t j = pool_size - wanted; j < pool_size; ++j) {
+                auto dist = std::uniform_int_distribution<size_t>(0, j);
+                size_t pick = dist(generator);
+                if (!chosen.insert(pick).second) {
+                    chosen.insert(j);
+                    pick = j;
+                }
+                picks.push_back(pick);
+            }
+            std::shuffle(picks.begin(), picks.end(), generator);
+        }
+
+        for (size_t pick : picks)
+            names.push_back((*this)[pick]);
+    }
+    return names;
+}
+
+long long NamePool::index_of(string_view name) const {
+    if (file.data() == nullptr || name.data() < file.data() || name.data() >= file.data() + file.size())
+        return -1;
+
+    auto offset = (uint32_t) (name.data() - file.data());
+    while (line_starts.back() <= offset && index_through(line_starts.size() - 1));
+
+    auto iter = std::upper_bound(line_starts.begin(), line_starts.end(), offset);
+    return (long long) (iter - line_starts.begin()) - 1;
+}
+
+bool NamePool::save_index() const {
+    if (!is_open()) return false;
+
+    NameIndexHeader header{};
+    memcpy(header.magic, name_index_magic, sizeof(header.magic));
+    header.version = name_index_version;
+    header.file_size = file.size();
+    header.line_count = size();
+
+    std::ofstream fs{filename + ".idx", std::ios::binary};
+    fs.write((const char*) &header, sizeof(header));
+    fs.write((const char*) line_starts.data(), (std::streamsize) (line_starts.size() * sizeof(uint32_t)));
+    return (bool) fs;
+}
+
+bool NamePool::index_through(size_t index) const {
+    while (line_starts.size() - 1 <= index) {
+        if (complete) return false;
+
+        const char* begin = file.data() + scanned;
+        auto newline = (const char*) memchr(begin, '\n', file.size() - scanned);
+        if (newline == nullptr) {
+            // The last line has no line break
+            line_starts.push_back((uint32_t) file.size() + 1);
+            scanned = file.size();
+        } else {
+            scanned = newline - file.data() + 1;
+            line_starts.push_back((uint32_t) scanned);
+        }
+        complete = scanned >= file.size();
+    }
+    return true;
+}
+
+bool NamePool::load_index() {
+    MappedFile index_file(filename + ".idx");
+    if (!index_file.is_open() || index_file.size() < sizeof(NameIndexHeader)) return false;
+
+    NameIndexHeader header{};
+    memcpy(&header, index_file.data(), sizeof(header));
+    if (memcmp(header.magic, name_index_magic, sizeof(header.magic)) != 0 ||
+        header.version != name_index_version || header.file_size != file.size())
+        return false;
+
+    size_t count = header.line_count + 1;
+    if (index_file.size() != sizeof(header) + count * sizeof(uint32_t)) return false;
+
+    line_starts.resize(count);
+    memcpy(line_starts.data(), index_file.data() + sizeof(header), count * sizeof(uint32_t));
+
+    // A stale or corrupt index must not hand out views past the mapping: lines start at 0, every line takes
+    // at least its line break, and the last one ends at the end of the file, or one past it when it has no
+    // line break
+    size_t size = file.size();
+    bool valid = line_starts.front() == 0 && (line_starts.back() == size || line_starts.back() == size + 1);
+    for (size_t i = 1; valid && i < count; ++i)
+        valid = line_starts[i - 1] < line_starts[i] && line_starts[i] <= size + 1;
+    if (!valid) return false;
+
+    scanned = file.size();
+    complete = true;
+    return true;
+}
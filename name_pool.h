@@ -0,0 +1,62 @@
+#ifndef ANIMAL_WORLD_NAME_POOL_H
+#define ANIMAL_WORLD_NAME_POOL_H
+
+#include "mapped_file.h"
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+// The lines of a names file, one name per line. The file is mapped rather than read, and names are
+// handed out as views into the mapping, so the pool must outlive every actor named from it.
+//
+// Lines are indexed lazily: taking the first N names only scans as far as the N-th line. The index
+// can be saved next to the file (<file>.idx) and is picked up from there on the next run.
+class NamePool {
+public:
+    NamePool() = default;
+
+    explicit NamePool(const std::string& filename);
+
+    [[nodiscard]] bool is_open() const { return file.is_open(); }
+
+    [[nodiscard]] const std::string& path() const { return filename; }
+
+    [[nodiscard]] size_t file_size() const { return file.size(); }
+
+    // Number of names; indexes the whole file
+    [[nodiscard]] size_t size() const;
+
+    // Scan until line `index` is known or the file ends; returns whether it exists
+    bool index_through(size_t index) const;
+
+    // The name on line `index`, which must exist
+    [[nodiscard]] std::string_view operator[](size_t index) const;
+
+    // The first count names, or every name when the file is shorter
+    [[nodiscard]] std::vector<std::string_view> first(size_t count) const;
+
+    // count distinct names drawn at random with the thread's generator; repeats only once the pool runs out
+    [[nodiscard]] std::vector<std::string_view> sample(size_t count) const;
+
+    // The line a view handed out by this pool came from, or -1 for any other string
+    [[nodiscard]] long long index_of(std::string_view name) const;
+
+    // Write the full line index to <file>.idx
+    bool save_index() const;
+
+private:
+    bool load_index();
+
+    std::string filename;
+    MappedFile file;
+
+    // Start of every indexed line, followed by one past the end of the last one. A pool without a file
+    // has no lines and nothing left to scan.
+    mutable std::vector<uint32_t> line_starts{0};
+    mutable size_t scanned = 0;
+    mutable bool complete = true;
+};
+
+#endif //ANIMAL_WORLD_NAME_POOL_H
@@ -0,0 +1,68 @@
+#include "game.h"
+#include "thread_pool.h"
+#include "compete_ranking.h"
+#include "round_arena.h"
+
+#include <iostream>
+#include <vector>
+
+using std::cerr;
+using std::endl;
+using std::vector;
+
+// Every actor still in the game, as a flat list of id, hand and stars
+static vector<int> state_of(const ActorRegistry& actors) {
+    vector<int> state;
+    for (auto& actor : actors)
+        state.insert(state.end(), {actor.id, actor.stone_count, actor.scissor_count, actor.paper_count,
+                                   actor.star_count});
+    return state;
+}
+
+// The state after each round of the game of seed, played as --parallel-phases plays it on pool
+static vector<vector<int>> play(ThreadPool& pool, unsigned seed, int actor_count, int round_count) {
+    generator.seed(seed);
+    auto actors = init_actors(actor_count, {});
+    Global global(actors);
+    global.seed = seed;
+    RoundArena arena;
+
+    vector<vector<int>> transcript;
+    for (int round = 0; round < round_count && !actors.empty(); ++round) {
+        RoundScope round_scope(arena);
+        auto list = compete_list(global);
+        auto_compete_parallel(global, list, pool, seed, (uint32_t) round);
+        remove_actors(global);
+        auto candidates = negotiate_candidates(global, list);
+        list = negotiate_list(candidates);
+        auto_negotiate_parallel(global, list, pool);
+        finish_round(global);
+        transcript.push_back(state_of(actors));
+    }
+    return transcript;
+}
+
+// The parallel phases draw every match from a stream keyed by the game, the round and the pair, so a game
+// must come out the same on any number of threads
+int main() {
+    const int thread_counts[] = {1, 2, 4, 7};
+    int failures = 0;
+    for (unsigned seed : {1u, 2u, 3u}) {
+        ThreadPool reference_pool(thread_counts[0]);
+        auto reference = play(reference_pool, seed, 5000, 20);
+
+        for (int thread_count : thread_counts) {
+            ThreadPool pool(thread_count);
+            auto transcript = play(pool, seed, 5000, 20);
+            if (transcript == reference) continue;
+
+            size_t round = 0;
+            while (round < transcript.size() && round < reference.size() && transcript[round] == reference[round])
+                ++round;
+            cerr << "seed " << seed << " on " << thread_count << " threads departs from " << thread_counts[0]
+                 << " thread in round " << round << endl;
+            ++failures;
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,34 @@
+#ifndef ANIMAL_WORLD_PHILOX_H
+#define ANIMAL_WORLD_PHILOX_H
+
+#include <array>
+#include <cstdint>
+
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3"). A pure function of
+// a 128-bit counter and a 64-bit key: any draw can be made on any thread, in any order, and come
+// out the same, which is what lets a phase be split across threads without changing its results.
+struct Philox {
+    using Block = std::array<uint32_t, 4>;
+
+    uint32_t key[2];
+
+    explicit Philox(uint64_t seed) : key{(uint32_t) seed, (uint32_t) (seed >> 32)} {}
+
+    [[nodiscard]] Block operator()(Block counter) const {
+        uint32_t k0 = key[0], k1 = key[1];
+        for (int round = 0; round < 10; ++round) {
+            uint64_t product0 = (uint64_t) 0xD2511F53 * counter[0];
+            uint64_t product1 = (uint64_t) 0xCD9E8D57 * counter[2];
+            counter = {(uint32_t) (product1 >> 32) ^ counter[1] ^ k0, (uint32_t) product1,
+                       (uint32_t) (product0 >> 32) ^ counter[3] ^ k1, (uint32_t) product0};
+            k0 += 0x9E3779B9;
+            k1 += 0xBB67AE85;
+        }
+        return counter;
+    }
+
+    // A float in [0, 1) from the top 24 bits of a draw
+    static float unit(uint32_t bits) { return (float) (bits >> 8) * (1.0f / 16777216.0f); }
+};
+
+#endif //ANIMAL_WORLD_PHILOX_H
@@ -0,0 +1,155 @@
+#include "policy.h"
+
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+
+using std::string;
+using std::vector;
+
+struct PolicyHeader {
+    char magic[4];
+    uint32_t version;
+    int32_t pool_steps;
+    int32_t max_cards;
+    int32_t max_stars;
+    int32_t round_count;
+    int32_t safe_star_count;
+    int32_t eliminated_star_count;
+    uint64_t entry_count;
+};
+
+static const char policy_magic[4] = {'A', 'W', 'P', 'T'};
+static const uint32_t policy_version = 1;
+
+static const uint16_t survival_scale = 0x3fff;
+
+size_t PolicyShape::entry_count() const {
+    auto hand_count = (size_t) (max_cards + 1) * (max_cards + 1) * (max_cards + 1);
+    return pool_count() * round_count * (max_stars + 1) * hand_count;
+}
+
+size_t PolicyShape::index(size_t pool, int round, int stars, const int hand[3]) const {
+    auto kinds = (size_t) (max_cards + 1);
+    size_t index = (pool * round_count + round) * (max_stars + 1) + stars;
+    return ((index * kinds + hand[0]) * kinds + hand[1]) * kinds + hand[2];
+}
+
+size_t PolicyShape::pool_index(int stone_steps, int scissor_steps) const {
+    // Rows of stone_steps hold pool_steps + 1, pool_steps, ... points
+    auto row_begin = (size_t) (stone_steps * (pool_steps + 1) - stone_steps * (stone_steps - 1) / 2);
+    return row_begin + scissor_steps;
+}
+
+bool PolicyShape::pool_of(const CardCounts& counts, size_t& pool) const {
+    int total = counts.total_count();
+    if (total <= 0) return false;
+
+    // Round down, then hand the steps left over to the largest remainders, which lands on the nearest point
+    int counts_by_kind[3] = {counts.stone_count, counts.scissor_count, counts.paper_count};
+    int steps[3];
+    long long remainders[3];
+    int left = pool_steps;
+    for (int i = 0; i < 3; ++i) {
+        auto scaled = (long long) counts_by_kind[i] * pool_steps;
+        steps[i] = (int) (scaled / total);
+        remainders[i] = scaled % total;
+        left -= steps[i];
+    }
+    for (; left > 0; --left) {
+        int largest = (int) (std::max_element(remainders, remainders + 3) - remainders);
+        ++steps[largest];
+        remainders[largest] = -1;
+    }
+
+    pool = pool_index(steps[0], steps[1]);
+    return true;
+}
+
+bool PolicyShape::fits(const Rules& game_rules, int game_round_count) const {
+    return rules.safe_star_count == game_rules.safe_star_count &&
+           rules.eliminated_star_count == game_rules.eliminated_star_count && round_count == game_round_count;
+}
+
+uint16_t pack_policy_entry(bool compete, Card card, float survival) {
+    auto move = (uint16_t) (compete ? 1 + (int) card : 0);
+    auto scaled = (uint16_t) (std::clamp(survival, 0.0f, 1.0f) * survival_scale + 0.5f);
+    return (uint16_t) (move << 14 | scaled);
+}
+
+PolicyAdvice unpack_policy_entry(uint16_t entry) {
+    PolicyAdvice advice;
+    advice.known = true;
+    int move = entry >> 14;
+    advice.compete = move > 0;
+    if (advice.compete) advice.card = (Card) (move - 1);
+    advice.survival = (float) (entry & survival_scale) / survival_scale;
+    return advice;
+}
+
+bool write_policy_table(const string& filename, const PolicyShape& shape, const vector<uint16_t>& entries) {
+    if (entries.size() != shape.entry_count()) return false;
+
+    PolicyHeader header{};
+    memcpy(header.magic, policy_magic, sizeof(header.magic));
+    header.version = policy_version;
+    header.pool_steps = shape.pool_steps;
+    header.max_cards = shape.max_cards;
+    header.max_stars = shape.max_stars;
+    header.round_count = shape.round_count;
+    header.safe_star_count = shape.rules.safe_star_count;
+    header.eliminated_star_count = shape.rules.eliminated_star_count;
+    header.entry_count = entries.size();
+
+    std::ofstream fs{filename, std::ios::binary};
+    fs.write((const char*) &header, sizeof(header));
+    fs.write((const char*) entries.data(), (std::streamsize) (entries.size() * sizeof(uint16_t)));
+    return (bool) fs;
+}
+
+PolicyTable::PolicyTable(const string& filename) : file{filename} {
+    if (!file.is_open() || file.size() < sizeof(PolicyHeader)) return;
+
+    PolicyHeader header{};
+    memcpy(&header, file.data(), sizeof(header));
+    if (memcmp(header.magic, policy_magic, sizeof(header.magic)) != 0 || header.version != policy_version) return;
+    if (header.pool_steps <= 0 || header.max_cards < 0 || header.max_stars < 0 || header.round_count <= 0)
+        return;
+
+    table_shape.pool_steps = header.pool_steps;
+    table_shape.max_cards = header.max_cards;
+    table_shape.max_stars = header.max_stars;
+    table_shape.round_count = header.round_count;
+    table_shape.rules.safe_star_count = header.safe_star_count;
+    table_shape.rules.eliminated_star_count = header.eliminated_star_count;
+    if (header.entry_count != table_shape.entry_count()) return;
+    if (file.size() != sizeof(header) + header.entry_count * sizeof(uint16_t)) return;
+
+    entries = (const uint16_t*) (file.data() + sizeof(header));
+}
+
+PolicyAdvice PolicyTable::advise(const CardCounts& counts, const Actor& actor, int round) const {
+    auto& shape = table_shape;
+    if (!is_open() || round < 0 || round >= shape.round_count) return {};
+    if (actor.star_count <= shape.rules.eliminated_star_count) return {};
+
+    int hand[3] = {actor.stone_count, actor.scissor_count, actor.paper_count};
+    for (int count : hand)
+        if (count < 0 || count > shape.max_cards) return {};
+
+    size_t pool;
+    if (!shape.pool_of(counts, pool)) return {};
+
+    int stars = std::min(actor.star_count, shape.max_stars);
+    uint16_t entry;
+    memcpy(&entry, entries + shape.index(pool, round, stars, hand), sizeof(entry));
+    return unpack_policy_entry(entry);
+}
+
+void render_policy_advice(Frame& frame, const PolicyAdvice& advice) {
+    if (!advice.known) return;
+    frame << "Advice:\t\t";
+    if (advice.compete) frame << "compete with " << verbose(advice.card);
+    else frame << "sit this round out";
+    frame << " (safe in " << (int) (advice.survival * 100 + 0.5f) << "% of games from here)\n";
+}
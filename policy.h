@@ -0,0 +1,91 @@
+#ifndef ANIMAL_WORLD_POLICY_H
+#define ANIMAL_WORLD_POLICY_H
+
+#include "game.h"
+#include "render.h"
+#include "mapped_file.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// The move a policy table recommends for the player's round
+struct PolicyAdvice {
+    // False when the table does not cover the player's state
+    bool known = false;
+    bool compete = false;
+    Card card = Card::STONE;
+
+    // The chance of ending safe when every later round follows the table too
+    float survival = 0;
+};
+
+// Which states a table covers, and how they are laid out in it. A state is the player's round, stars and hand,
+// and the pool: the shares of stones, scissors and papers among the cards everyone else holds, rounded to the
+// nearest multiple of 1 / pool_steps. Entries run by pool, round, stars, stones, scissors and papers, the last
+// varying fastest, so that finding one takes a few multiplications.
+struct PolicyShape {
+    int pool_steps = 10;
+    // Hands of up to max_cards of each kind, and 0 to max_stars stars; more stars read as max_stars
+    int max_cards = 6;
+    int max_stars = 9;
+    int round_count = 20;
+    Rules rules;
+
+    // Pools are the points of the triangle stones + scissors + papers = pool_steps
+    [[nodiscard]] size_t pool_count() const { return (size_t) (pool_steps + 1) * (pool_steps + 2) / 2; }
+
+    [[nodiscard]] size_t entry_count() const;
+
+    [[nodiscard]] size_t index(size_t pool, int round, int stars, const int hand[3]) const;
+
+    // The pool of stone and scissor steps, the rest being papers
+    [[nodiscard]] size_t pool_index(int stone_steps, int scissor_steps) const;
+
+    // The pool nearest the shares of counts; false when there are no cards to share
+    bool pool_of(const CardCounts& counts, size_t& pool) const;
+
+    // Whether the table was solved for a game of these rules and rounds
+    [[nodiscard]] bool fits(const Rules& game_rules, int game_round_count) const;
+};
+
+// An entry packs the move in its two high bits, 0 for sitting out and 1 + card for competing with card, and
+// the chance of ending safe in the other fourteen, as a fraction of 16383
+uint16_t pack_policy_entry(bool compete, Card card, float survival);
+
+PolicyAdvice unpack_policy_entry(uint16_t entry);
+
+// A table as the solver writes it: a header with the shape, then entry_count() entries
+bool write_policy_table(const std::string& filename, const PolicyShape& shape, const std::vector<uint16_t>& entries);
+
+// A table the solver wrote, mapped into memory. Looking a state up reads one entry, whatever the table's size,
+// and tables are only read, so one serves any number of games on any number of threads.
+class PolicyTable {
+public:
+    PolicyTable() = default;
+
+    // Check is_open() for whether the file held a table
+    explicit PolicyTable(const std::string& filename);
+
+    // entries points into the mapping
+    PolicyTable(const PolicyTable&) = delete;
+
+    PolicyTable& operator=(const PolicyTable&) = delete;
+
+    [[nodiscard]] bool is_open() const { return entries != nullptr; }
+
+    [[nodiscard]] const PolicyShape& shape() const { return table_shape; }
+
+    // The move for actor in round, counts being the cards everyone else holds
+    [[nodiscard]] PolicyAdvice advise(const CardCounts& counts, const Actor& actor, int round) const;
+
+private:
+    MappedFile file;
+    PolicyShape table_shape;
+    const uint16_t* entries = nullptr;
+};
+
+void render_policy_advice(Frame& frame, const PolicyAdvice& advice);
+
+#endif //ANIMAL_WORLD_POLICY_H
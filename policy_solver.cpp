@@ -0,0 +1,221 @@
+#include "policy.h"
+#include "thread_pool.h"
+
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <algorithm>
+
+using std::cout;
+using std::cerr;
+using std::endl;
+using std::vector;
+using std::string;
+
+// The chance that someone takes a spare card off the player in a round, once the player has the stars to be safe
+static const float giveaway_chance = 0.5f;
+
+// Expected survival of every state of one pool, by backward induction over the rounds.
+//
+// The player's rounds are a Markov decision process. A round starts from the player's hand and stars; the
+// player sits out or competes with one of their cards. A player who competes always meets someone, as the
+// compete list is almost never empty, and the opponent's card is drawn the way the heuristic plays: a card
+// held in proportion to its share of the pool, and weighted by the share of the card it beats. Only a player
+// who sat out negotiates, and one with the stars to be safe gets a spare card of their choice taken with
+// giveaway_chance. The pool itself is taken to keep its shares for the rest of the game.
+class PoolSolver {
+public:
+    PoolSolver(const PolicyShape& shape, size_t pool, vector<uint16_t>& entries)
+            : shape{shape}, pool{pool}, entries{entries}, kinds{shape.max_cards + 1},
+              hand_count{(size_t) kinds * kinds * kinds},
+              values((size_t) shape.round_count * (shape.max_stars + 1) * hand_count) {
+        // Recover the pool's shares from its index by walking the triangle in the same order
+        for (int stone_steps = 0; stone_steps <= shape.pool_steps; ++stone_steps) {
+            for (int scissor_steps = 0; stone_steps + scissor_steps <= shape.pool_steps; ++scissor_steps) {
+                if (shape.pool_index(stone_steps, scissor_steps) != pool) continue;
+                shares[0] = (float) stone_steps / (float) shape.pool_steps;
+                shares[1] = (float) scissor_steps / (float) shape.pool_steps;
+                shares[2] = 1 - shares[0] - shares[1];
+            }
+        }
+
+        float sum = 0;
+        for (int card = 0; card < 3; ++card) {
+            opponent_odds[card] = shares[card] * shares[(card + 1) % 3];
+            sum += opponent_odds[card];
+        }
+        // One kind of card left in play: the opponent can only hold that
+        for (int card = 0; card < 3; ++card)
+            opponent_odds[card] = sum > 0 ? opponent_odds[card] / sum : shares[card];
+    }
+
+    void solve() {
+        for (int round = shape.round_count - 1; round >= 0; --round) {
+            for (int stars = 0; stars <= shape.max_stars; ++stars) {
+                int hand[3];
+                for (hand[0] = 0; hand[0] < kinds; ++hand[0])
+                    for (hand[1] = 0; hand[1] < kinds; ++hand[1])
+                        for (hand[2] = 0; hand[2] < kinds; ++hand[2])
+                            solve_state(round, stars, hand);
+            }
+        }
+    }
+
+private:
+    float& value(int round, int stars, const int hand[3]) {
+        size_t index = ((size_t) round * (shape.max_stars + 1) + stars) * hand_count;
+        return values[index + ((size_t) hand[0] * kinds + hand[1]) * kinds + hand[2]];
+    }
+
+    [[nodiscard]] bool is_safe(int stars, const int hand[3]) const {
+        return stars >= shape.rules.safe_star_count && hand[0] + hand[1] + hand[2] == 0;
+    }
+
+    // The player starts the next round with stars and hand
+    float next_round(int round, int stars, const int hand[3]) {
+        // The player is only checked after a match, so one more round must be played to be found safe
+        if (round + 1 >= shape.round_count) return 0;
+        if (is_safe(stars, hand)) return 1;
+        return value(round + 1, stars, hand);
+    }
+
+    // The player is checked after the compete phase of round, then negotiates if they sat out
+    float after_match(int round, int stars, int hand[3], bool sat_out) {
+        stars = std::min(stars, shape.max_stars);
+        if (is_safe(stars, hand)) return 1;
+        if (stars <= shape.rules.eliminated_star_count) return 0;
+
+        float kept = next_round(round, stars, hand);
+        if (!sat_out || stars < shape.rules.safe_star_count || hand[0] + hand[1] + hand[2] == 0) return kept;
+
+        float given = 0;
+        for (int card = 0; card < 3; ++card) {
+            if (hand[card] == 0) continue;
+            --hand[card];
+            given = std::max(given, next_round(round, stars, hand));
+            ++hand[card];
+        }
+        return giveaway_chance * given + (1 - giveaway_chance) * kept;
+    }
+
+    void solve_state(int round, int stars, int hand[3]) {
+        bool compete = false;
+        Card best_card = Card::STONE;
+        float best = 0;
+
+        if (stars <= shape.rules.eliminated_star_count) {
+            best = 0;
+        } else if (is_safe(stars, hand)) {
+            best = 1;
+        } else {
+            best = after_match(round, stars, hand, true);
+            for (int card = 0; card < 3; ++card) {
+                if (hand[card] == 0) continue;
+                --hand[card];
+                float survival = 0;
+                for (int other = 0; other < 3; ++other) {
+                    if (opponent_odds[other] <= 0) continue;
+                    int result = single_compete((Card) card, (Card) other);
+                    survival += opponent_odds[other] * after_match(round, stars + result, hand, false);
+                }
+                ++hand[card];
+
+                // Sitting out is kept on a tie, and so is the first of equally good cards
+                if (survival > best) {
+                    best = survival;
+                    compete = true;
+                    best_card = (Card) card;
+                }
+            }
+        }
+
+        value(round, stars, hand) = best;
+        entries[shape.index(pool, round, stars, hand)] = pack_policy_entry(compete, best_card, best);
+    }
+
+    const PolicyShape& shape;
+    size_t pool;
+    vector<uint16_t>& entries;
+
+    int kinds;
+    size_t hand_count;
+    float shares[3] = {};
+    float opponent_odds[3] = {};
+
+    // Survival by round, stars and hand
+    vector<float> values;
+};
+
+static void solver_usage() {
+    cerr << "Usage: animal_world_policy [--output FILE] [--pool-steps N] [--max-cards N] [--max-stars N] [--rounds N]"
+         << " [--safe-stars N] [--eliminated-stars N] [--threads N]" << endl;
+}
+
+// Solve every state of the player and write them as a policy table, policy.bin unless told otherwise
+int main(int argc, char** argv) {
+    string output = "policy.bin";
+    PolicyShape shape;
+    int thread_count = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (value == nullptr) {
+            solver_usage();
+            return 1;
+        }
+
+        if (strcmp(arg, "--output") == 0) output = value;
+        else if (strcmp(arg, "--pool-steps") == 0) shape.pool_steps = std::stoi(value);
+        else if (strcmp(arg, "--max-cards") == 0) shape.max_cards = std::stoi(value);
+        else if (strcmp(arg, "--max-stars") == 0) shape.max_stars = std::stoi(value);
+        else if (strcmp(arg, "--rounds") == 0) shape.round_count = std::stoi(value);
+        else if (strcmp(arg, "--safe-stars") == 0) shape.rules.safe_star_count = std::stoi(value);
+        else if (strcmp(arg, "--eliminated-stars") == 0) shape.rules.eliminated_star_count = std::stoi(value);
+        else if (strcmp(arg, "--threads") == 0) thread_count = std::stoi(value);
+        else {
+            solver_usage();
+            return 1;
+        }
+        ++i;
+    }
+
+    // The table grows with the cube of max_cards and the square of pool_steps, so both are kept within reason
+    if (shape.pool_steps <= 0 || shape.pool_steps > 100 || shape.max_cards < 0 || shape.max_cards > 30 ||
+        shape.round_count <= 0 || shape.rules.eliminated_star_count < 0 ||
+        shape.rules.safe_star_count <= shape.rules.eliminated_star_count ||
+        shape.max_stars < shape.rules.safe_star_count) {
+        cerr << "The table needs 1 to 100 pool steps, 0 to 30 cards, a positive round count, and"
+             << " eliminated-stars < safe-stars <= max-stars" << endl;
+        return 1;
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    vector<uint16_t> entries(shape.entry_count());
+    // Pools never meet, so each is solved on its own
+    ThreadPool pool(thread_count);
+    pool.parallel_for(shape.pool_count(), [&](size_t index, int) {
+        PoolSolver solver(shape, index, entries);
+        solver.solve();
+    });
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+
+    if (!write_policy_table(output, shape, entries)) {
+        cerr << "Cannot write the policy table to " << output << endl;
+        return 1;
+    }
+
+    cout << "Solved " << entries.size() << " states in " << elapsed.count() << " s" << endl;
+    cout << "Wrote " << entries.size() * sizeof(uint16_t) << " bytes of entries to " << output << endl;
+
+    // How the player fares from the start of a game against an even pool
+    Rules rules;
+    Actor player{0, "Player", rules.stone_count, rules.scissor_count, rules.paper_count, rules.star_count};
+    PolicyTable table(output);
+    CardCounts even{1, 1, 1};
+    auto advice = table.advise(even, player, 0);
+    if (advice.known) cout << "Survival from the start against an even pool: " << advice.survival << endl;
+    return 0;
+}
@@ -0,0 +1,146 @@
+#include "profiler.h"
+
+#include <fstream>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using std::vector;
+using std::string;
+
+thread_local Profiler* current_profiler = nullptr;
+thread_local Phase current_phase = Phase::OTHER;
+
+#ifdef ANIMAL_WORLD_PROFILE
+static std::atomic<long long> heap_allocation_count{0};
+
+void* operator new(size_t size) {
+    heap_allocation_count.fetch_add(1, std::memory_order_relaxed);
+    profile_count(Counter::ALLOCATIONS);
+    if (void* pointer = std::malloc(size == 0 ? 1 : size)) return pointer;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    std::free(pointer);
+}
+
+long long profiled_heap_allocations() {
+    return heap_allocation_count.load(std::memory_order_relaxed);
+}
+#endif
+
+const char* phase_name(Phase phase) {
+    switch (phase) {
+        case Phase::CANDIDATES:
+            return "candidates";
+        case Phase::LISTS:
+            return "lists";
+        case Phase::COMPETITION:
+            return "competition";
+        case Phase::ELIMINATION:
+            return "elimination";
+        case Phase::NEGOTIATION:
+            return "negotiation";
+        case Phase::DISPLAY:
+            return "display";
+        case Phase::OTHER:
+            return "other";
+    }
+    return "unknown";
+}
+
+const char* counter_name(Counter counter) {
+    switch (counter) {
+        case Counter::WILL_CALLS:
+            return "will_calls";
+        case Counter::PROBABILITY_CALLS:
+            return "probability_calls";
+        case Counter::RNG_DRAWS:
+            return "rng_draws";
+        case Counter::ALLOCATIONS:
+            return "allocations";
+    }
+    return "unknown";
+}
+
+void PhaseProfile::merge(const PhaseProfile& other) {
+    entries += other.entries;
+    seconds += other.seconds;
+    for (int i = 0; i < counter_count; ++i)
+        counters[i] += other.counters[i];
+}
+
+void RoundProfile::merge(const RoundProfile& other) {
+    for (int i = 0; i < phase_count; ++i)
+        phases[i].merge(other.phases[i]);
+}
+
+void Profiler::set_round(int round) {
+    if ((int) rounds.size() <= round) rounds.resize(round + 1);
+    this->round = round;
+}
+
+void Profiler::merge(const Profiler& other) {
+    if (rounds.size() < other.rounds.size()) rounds.resize(other.rounds.size());
+    for (size_t i = 0; i < other.rounds.size(); ++i)
+        rounds[i].merge(other.rounds[i]);
+}
+
+bool Profiler::enabled() {
+#ifdef ANIMAL_WORLD_PROFILE
+    return true;
+#else
+    return false;
+#endif
+}
+
+static void write_round(std::ofstream& fs, const RoundProfile& profile, const char* indent) {
+    fs << "{";
+    for (int i = 0; i < phase_count; ++i) {
+        auto& phase = profile.phases[i];
+        fs << (i == 0 ? "\n" : ",\n") << indent << "  \"" << phase_name((Phase) i) << "\": {\"entries\": "
+           << phase.entries << ", \"seconds\": " << phase.seconds;
+        for (int j = 0; j < counter_count; ++j)
+            fs << ", \"" << counter_name((Counter) j) << "\": " << phase.counters[j];
+        fs << "}";
+    }
+    fs << "\n" << indent << "}";
+}
+
+bool Profiler::write_json(const string& filename) const {
+    std::ofstream fs{filename};
+
+    RoundProfile total;
+    for (auto& profile : rounds)
+        total.merge(profile);
+
+    fs << "{\n  \"total\": ";
+    write_round(fs, total, "  ");
+    fs << ",\n  \"rounds\": [";
+    for (size_t i = 0; i < rounds.size(); ++i) {
+        fs << (i == 0 ? "\n    " : ",\n    ");
+        write_round(fs, rounds[i], "    ");
+    }
+    fs << "\n  ]\n}\n";
+    return (bool) fs;
+}
+
+PhaseScope::PhaseScope(Phase phase) : phase{phase}, previous{current_phase} {
+    current_phase = phase;
+    start = std::chrono::steady_clock::now();
+}
+
+PhaseScope::~PhaseScope() {
+    if (current_profiler != nullptr) {
+        auto& profile = current_profiler->current().phases[(int) phase];
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        ++profile.entries;
+        profile.seconds += elapsed.count();
+    }
+    current_phase = previous;
+}
@@ -0,0 +1,136 @@
+#ifndef ANIMAL_WORLD_PROFILER_H
+#define ANIMAL_WORLD_PROFILER_H
+
+#include <vector>
+#include <string>
+#include <chrono>
+
+// Time and counters for each phase of a round, built in with -DANIMAL_WORLD_PROFILE=ON.
+//
+// PROFILE_PHASE opens a phase until the end of the enclosing block, and PROFILE_COUNT counts an event
+// against the phase open on the calling thread. Both compile to nothing in other builds, so the
+// instrumented code costs nothing there. A Profiler collects while a ProfilerScope makes it the profiler of
+// a thread; rounds are told apart by set_round, and rounds of the same number in different games add up.
+
+enum class Phase {
+    CANDIDATES,
+    LISTS,
+    COMPETITION,
+    ELIMINATION,
+    NEGOTIATION,
+    DISPLAY,
+    // Anything counted outside the phases above
+    OTHER,
+};
+
+constexpr int phase_count = (int) Phase::OTHER + 1;
+
+enum class Counter {
+    WILL_CALLS,
+    PROBABILITY_CALLS,
+    RNG_DRAWS,
+    ALLOCATIONS,
+};
+
+constexpr int counter_count = (int) Counter::ALLOCATIONS + 1;
+
+const char* phase_name(Phase phase);
+
+const char* counter_name(Counter counter);
+
+struct PhaseProfile {
+    long long entries = 0;
+    double seconds = 0;
+    long long counters[counter_count] = {};
+
+    void merge(const PhaseProfile& other);
+};
+
+struct RoundProfile {
+    PhaseProfile phases[phase_count];
+
+    void merge(const RoundProfile& other);
+};
+
+class Profiler {
+public:
+    // Counts from now on belong to this round
+    void set_round(int round);
+
+    void merge(const Profiler& other);
+
+    // Per-round profiles and their sum over the run
+    bool write_json(const std::string& filename) const;
+
+    // The profile of the current round, where phases record into
+    RoundProfile& current() { return rounds[round]; }
+
+    [[nodiscard]] int current_round() const { return round; }
+
+    [[nodiscard]] static bool enabled();
+
+private:
+    std::vector<RoundProfile> rounds{1};
+    int round = 0;
+};
+
+#ifdef ANIMAL_WORLD_PROFILE
+// Heap allocations of the whole process; profiling builds replace operator new to count them
+long long profiled_heap_allocations();
+#endif
+
+// The profiler of the calling thread and the phase open on it; for the macros below
+extern thread_local Profiler* current_profiler;
+extern thread_local Phase current_phase;
+
+inline void profile_count(Counter counter, long long count = 1) {
+    if (current_profiler != nullptr)
+        current_profiler->current().phases[(int) current_phase].counters[(int) counter] += count;
+}
+
+// Counts on the calling thread belong to this round from now on
+inline void profile_round(int round) {
+    if (current_profiler != nullptr) current_profiler->set_round(round);
+}
+
+// Makes a profiler the one of the calling thread while it lives
+class ProfilerScope {
+public:
+    explicit ProfilerScope(Profiler* profiler) : previous{current_profiler} { current_profiler = profiler; }
+
+    ~ProfilerScope() { current_profiler = previous; }
+
+    ProfilerScope(const ProfilerScope&) = delete;
+
+    ProfilerScope& operator=(const ProfilerScope&) = delete;
+
+private:
+    Profiler* previous;
+};
+
+// Opens a phase while it lives; the phase that was open before takes over again afterwards
+class PhaseScope {
+public:
+    explicit PhaseScope(Phase phase);
+
+    ~PhaseScope();
+
+    PhaseScope(const PhaseScope&) = delete;
+
+    PhaseScope& operator=(const PhaseScope&) = delete;
+
+private:
+    Phase phase;
+    Phase previous;
+    std::chrono::steady_clock::time_point start;
+};
+
+#ifdef ANIMAL_WORLD_PROFILE
+#define PROFILE_PHASE(phase) PhaseScope profile_phase_scope{phase}
+#define PROFILE_COUNT(counter) profile_count(counter)
+#else
+#define PROFILE_PHASE(phase) ((void) 0)
+#define PROFILE_COUNT(counter) ((void) 0)
+#endif
+
+#endif //ANIMAL_WORLD_PROFILER_H
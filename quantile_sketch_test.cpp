@@ -0,0 +1,82 @@
+#include "sweep.h"
+
+#include <iostream>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+using std::cerr;
+using std::endl;
+using std::vector;
+
+static const double quantiles[] = {0, 0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99, 1};
+
+// The sketch of parts merged in the given order
+static QuantileSketch merged(const vector<QuantileSketch>& parts, const vector<size_t>& order) {
+    QuantileSketch sketch;
+    for (size_t i : order)
+        sketch.merge(parts[i]);
+    return sketch;
+}
+
+static bool same_quantiles(const QuantileSketch& s1, const QuantileSketch& s2) {
+    if (s1.count() != s2.count()) return false;
+    for (double q : quantiles)
+        if (s1.quantile(q) != s2.quantile(q)) return false;
+    return true;
+}
+
+// Sweeps fold games into per-worker sketches and merge them in whatever order workers finish, so a sketch must
+// come out the same however its values are split and merged, and within its relative error of the exact quantile
+int main() {
+    const size_t value_count = 20000;
+    const size_t part_count = 8;
+    std::mt19937 engine(7);
+    std::uniform_real_distribution<double> fraction(0, 1);
+
+    // Survival fractions, a tenth of them 0 as for games where nobody ends safe
+    vector<double> values(value_count);
+    for (auto& value : values)
+        value = fraction(engine) < 0.1 ? 0 : fraction(engine);
+
+    QuantileSketch whole;
+    vector<QuantileSketch> parts(part_count);
+    for (size_t i = 0; i < value_count; ++i) {
+        whole.add(values[i]);
+        parts[i * part_count / value_count].add(values[i]);
+    }
+
+    int failures = 0;
+    vector<size_t> order(part_count);
+    for (size_t i = 0; i < part_count; ++i) order[i] = i;
+    for (int trial = 0; trial < 20; ++trial) {
+        std::shuffle(order.begin(), order.end(), engine);
+        if (!same_quantiles(merged(parts, order), whole)) {
+            cerr << "merging in order";
+            for (size_t i : order) cerr << ' ' << i;
+            cerr << " differs from adding every value to one sketch" << endl;
+            ++failures;
+        }
+    }
+
+    // Merged as a tree, the way a worker's share is merged into another's
+    vector<QuantileSketch> halves(2);
+    for (size_t i = 0; i < part_count; ++i)
+        halves[i % 2].merge(parts[i]);
+    if (!same_quantiles(merged(halves, {1, 0}), whole)) {
+        cerr << "merging in halves differs from adding every value to one sketch" << endl;
+        ++failures;
+    }
+
+    std::sort(values.begin(), values.end());
+    for (double q : quantiles) {
+        double exact = values[(size_t) (q * (double) (value_count - 1))];
+        double estimate = whole.quantile(q);
+        if (std::abs(estimate - exact) > 0.01 * exact + 1e-12) {
+            cerr << "quantile " << q << " is " << estimate << ", exactly " << exact << endl;
+            ++failures;
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
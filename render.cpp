@@ -0,0 +1,166 @@
+#include "render.h"
+
+#include <algorithm>
+#include <vector>
+#include <charconv>
+#include <tuple>
+#include <utility>
+#include <cstdio>
+
+using std::vector;
+
+Frame& Frame::operator<<(std::string_view text) {
+    buffer.append(text);
+    return *this;
+}
+
+Frame& Frame::operator<<(char c) {
+    buffer.push_back(c);
+    return *this;
+}
+
+Frame& Frame::operator<<(long long value) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    buffer.append(digits, result.ptr);
+    return *this;
+}
+
+Frame& Frame::operator<<(size_t value) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    buffer.append(digits, result.ptr);
+    return *this;
+}
+
+Frame& Frame::operator<<(double value) {
+    // What an ostream prints with its default precision of 6
+    char digits[32];
+    int length = snprintf(digits, sizeof(digits), "%g", value);
+    buffer.append(digits, length);
+    return *this;
+}
+
+Frame& Frame::repeat(char c, int count) {
+    if (count > 0) buffer.append((size_t) count, c);
+    return *this;
+}
+
+void Frame::present(std::ostream& os) {
+    os.write(buffer.data(), (std::streamsize) buffer.size());
+    os.flush();
+    buffer.clear();
+}
+
+void render_counts(Frame& frame, const CardCounts& counts) {
+    frame << "Stones: " << counts.stone_count << '\n';
+    frame << "Scissors: " << counts.scissor_count << '\n';
+    frame << "Papers: " << counts.paper_count << '\n';
+}
+
+void render_actor_all(Frame& frame, const Global& global, const Actor& actor) {
+    frame << actor.name << "\t\t";
+    frame << actor.stone_count << '\t';
+    frame << actor.scissor_count << '\t';
+    frame << actor.paper_count << "\t\t";
+    frame.repeat('*', actor.star_count) << "\t\t";
+    frame << actor_predict_success(global, actor) << '\t';
+    frame << actor_predict_fail(global, actor) << '\t';
+    frame << '\n';
+}
+
+void render_actor_concise(Frame& frame, const Actor& actor) {
+    frame << actor.name << "\t\t";
+    frame.repeat('*', actor.star_count) << '\n';
+}
+
+void render_check_actor(Frame& frame, Global& global, const Actor& actor) {
+    auto result = check_actor(global, actor);
+    if (result == CheckResult::WIN) frame << actor.name << " is safe\n";
+    else if (result == CheckResult::LOSE) frame << actor.name << " is eliminated\n";
+}
+
+// Which part of a list of total_count entries a view shows
+static std::pair<size_t, size_t> page_range(const ListView& view, size_t total_count) {
+    if (view.page_size == 0) return {0, total_count};
+    size_t begin = std::min(view.page * view.page_size, total_count);
+    return {begin, std::min(begin + view.page_size, total_count)};
+}
+
+static void render_page_footer(Frame& frame, size_t begin, size_t end, size_t total_count) {
+    if (end - begin == total_count) return;
+    if (begin == end) frame << "(nothing more to show, " << total_count << " in all)\n";
+    else frame << "(" << begin + 1 << "-" << end << " of " << total_count << ")\n";
+}
+
+size_t render_standings(Frame& frame, Global& global, const ListView& view) {
+    global.refresh();
+
+    auto ranks_before = [](const Actor* a, const Actor* b) {
+        // Storage is dense, so addresses give storage order
+        return a->star_count != b->star_count ? a->star_count > b->star_count : a < b;
+    };
+
+    vector<const Actor*> ranked;
+    size_t total_count;
+    size_t begin, end;
+    if (view.filter) {
+        for (const Actor& actor : global.actors)
+            if (view.filter(actor)) ranked.push_back(&actor);
+        total_count = ranked.size();
+        std::tie(begin, end) = page_range(view, total_count);
+        std::partial_sort(ranked.begin(), ranked.begin() + (long) end, ranked.end(), ranks_before);
+    } else {
+        total_count = global.actors.size();
+        std::tie(begin, end) = page_range(view, total_count);
+
+        // The lowest star count on the page, and how many of the actors holding it make the page
+        auto& histogram = global.star_histogram;
+        int threshold = (int) histogram.size() - 1;
+        size_t above_count = 0;
+        while (threshold > 0 && above_count + histogram[threshold] < end)
+            above_count += histogram[threshold--];
+        // Negative counts share the bottom index with zero, so the bottom level is collected whole, in no
+        // order, and only the sort tells which of its actors make the page
+        bool bottom = threshold <= 0;
+        size_t tie_count = bottom ? total_count : end - above_count;
+
+        ranked.reserve(bottom ? total_count : end);
+        for (const Actor& actor : global.actors) {
+            if (!bottom && ranked.size() == end) break;
+            int star_index = std::max(actor.star_count, 0);
+            if (star_index > threshold) {
+                ranked.push_back(&actor);
+            } else if (star_index == threshold && tie_count > 0) {
+                ranked.push_back(&actor);
+                --tie_count;
+            }
+        }
+        std::partial_sort(ranked.begin(), ranked.begin() + (long) end, ranked.end(), ranks_before);
+        ranked.resize(end);
+    }
+
+    frame << "Name\t\tStars\n";
+    for (size_t i = begin; i < end; ++i)
+        render_actor_concise(frame, *ranked[i]);
+    render_page_footer(frame, begin, end, total_count);
+    return total_count;
+}
+
+void render_actor_list(Frame& frame, const ActorRegistry& actors, const HandleList& list, const ListView& view) {
+    size_t total_count = list.size();
+    if (view.filter)
+        total_count = std::count_if(list.begin(), list.end(), [&](ActorHandle handle) {
+            return view.filter(actors[handle]);
+        });
+
+    auto [begin, end] = page_range(view, total_count);
+    size_t index = 0;
+    for (ActorHandle handle : list) {
+        if (index == end) break;
+        auto& actor = actors[handle];
+        if (view.filter && !view.filter(actor)) continue;
+        if (index++ >= begin) render_actor_concise(frame, actor);
+    }
+    render_page_footer(frame, begin, end, total_count);
+}
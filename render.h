@@ -0,0 +1,78 @@
+#ifndef ANIMAL_WORLD_RENDER_H
+#define ANIMAL_WORLD_RENDER_H
+
+#include "game.h"
+
+#include <string>
+#include <string_view>
+#include <functional>
+#include <ostream>
+#include <cstddef>
+
+// One screen of console output, composed in memory and written at once. Numbers are formatted the way
+// an ostream with default flags would, so a frame prints exactly what the line-by-line output did.
+class Frame {
+public:
+    Frame& operator<<(std::string_view text);
+
+    Frame& operator<<(const char* text) { return *this << std::string_view{text}; }
+
+    Frame& operator<<(const std::string& text) { return *this << std::string_view{text}; }
+
+    Frame& operator<<(char c);
+
+    Frame& operator<<(int value) { return *this << (long long) value; }
+
+    Frame& operator<<(long long value);
+
+    Frame& operator<<(size_t value);
+
+    Frame& operator<<(double value);
+
+    Frame& operator<<(const Frame& other) { return *this << std::string_view{other.buffer}; }
+
+    // count copies of a character
+    Frame& repeat(char c, int count);
+
+    [[nodiscard]] size_t size() const { return buffer.size(); }
+
+    [[nodiscard]] std::string_view text() const { return buffer; }
+
+    void clear() { buffer.clear(); }
+
+    // Write everything composed so far with a single write and flush, and start over
+    void present(std::ostream& os);
+
+private:
+    std::string buffer;
+};
+
+// A bounded window on a list of actors, so that what a view prints does not grow with the population
+struct ListView {
+    // Lines per page; 0 shows the whole list
+    size_t page_size = 0;
+
+    size_t page = 0;
+
+    // Only actors this accepts are listed; every actor when empty
+    std::function<bool(const Actor&)> filter;
+};
+
+void render_counts(Frame& frame, const CardCounts& counts);
+
+void render_actor_all(Frame& frame, const Global& global, const Actor& actor);
+
+void render_actor_concise(Frame& frame, const Actor& actor);
+
+// A line saying the actor is safe or eliminated, if it is
+void render_check_actor(Frame& frame, Global& global, const Actor& actor);
+
+// The actors ranked by stars, ties in storage order, one page of them. Without a filter the star
+// histogram of global tells how far down the ranking the page ends, so the scan stops as soon as it has
+// the actors of the page. Returns how many actors the ranking holds.
+size_t render_standings(Frame& frame, Global& global, const ListView& view);
+
+// One page of the listed actors, in list order, with a line saying how many are left out
+void render_actor_list(Frame& frame, const ActorRegistry& actors, const HandleList& list, const ListView& view);
+
+#endif //ANIMAL_WORLD_RENDER_H
@@ -0,0 +1,49 @@
+#include "round_arena.h"
+
+static thread_local std::pmr::memory_resource* current_round_resource = nullptr;
+
+void* CountingResource::do_allocate(size_t bytes, size_t alignment) {
+    ++counts.allocations;
+    counts.bytes += (long long) bytes;
+    return upstream->allocate(bytes, alignment);
+}
+
+void CountingResource::do_deallocate(void* pointer, size_t bytes, size_t alignment) {
+    upstream->deallocate(pointer, bytes, alignment);
+}
+
+bool CountingResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+RoundArena::RoundArena(size_t initial_size) : buffer(initial_size) {
+    monotonic.emplace(buffer.data(), buffer.size(), &heap);
+    served.set_upstream(&*monotonic);
+}
+
+void RoundArena::reset() {
+    auto overflow = (size_t) (heap.counters().bytes - heap_bytes_at_reset);
+    heap_bytes_at_reset = heap.counters().bytes;
+
+    // Nothing may still point into the buffer, so it can be replaced as well as rewound
+    monotonic.reset();
+    if (overflow > 0) {
+        size_t size = buffer.size() + overflow;
+        buffer = std::vector<std::byte>(size);
+    }
+    monotonic.emplace(buffer.data(), buffer.size(), &heap);
+    served.set_upstream(&*monotonic);
+}
+
+std::pmr::memory_resource* round_resource() {
+    return current_round_resource != nullptr ? current_round_resource : std::pmr::get_default_resource();
+}
+
+RoundScope::RoundScope(RoundArena& arena) : arena{arena}, previous{current_round_resource} {
+    current_round_resource = arena.resource();
+}
+
+RoundScope::~RoundScope() {
+    current_round_resource = previous;
+    arena.reset();
+}
@@ -0,0 +1,87 @@
+#ifndef ANIMAL_WORLD_ROUND_ARENA_H
+#define ANIMAL_WORLD_ROUND_ARENA_H
+
+#include <memory_resource>
+#include <vector>
+#include <optional>
+#include <cstddef>
+
+struct AllocationCounters {
+    long long allocations = 0;
+    long long bytes = 0;
+};
+
+// A memory resource that counts what it hands out and passes everything on to another one
+class CountingResource : public std::pmr::memory_resource {
+public:
+    explicit CountingResource(std::pmr::memory_resource* upstream) : upstream{upstream} {}
+
+    [[nodiscard]] const AllocationCounters& counters() const { return counts; }
+
+    void set_upstream(std::pmr::memory_resource* resource) { upstream = resource; }
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+
+    void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+
+    [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    std::pmr::memory_resource* upstream;
+    AllocationCounters counts;
+};
+
+// Memory for the lists a round builds. Everything is bump-allocated from one buffer and given back at
+// once by reset(). When a round outgrows the buffer the excess comes from the heap, and the buffer grows
+// to fit at the next reset, so once rounds stop growing they no longer touch the heap at all.
+class RoundArena {
+public:
+    explicit RoundArena(size_t initial_size = 64 * 1024);
+
+    RoundArena(const RoundArena&) = delete;
+
+    RoundArena& operator=(const RoundArena&) = delete;
+
+    [[nodiscard]] std::pmr::memory_resource* resource() { return &served; }
+
+    // Give back everything allocated since the last reset
+    void reset();
+
+    // Everything the arena handed out, and the part of it that had to come from the heap
+    [[nodiscard]] const AllocationCounters& served_counters() const { return served.counters(); }
+
+    [[nodiscard]] const AllocationCounters& heap_counters() const { return heap.counters(); }
+
+    [[nodiscard]] size_t capacity() const { return buffer.size(); }
+
+private:
+    CountingResource heap{std::pmr::new_delete_resource()};
+    std::vector<std::byte> buffer;
+    std::optional<std::pmr::monotonic_buffer_resource> monotonic;
+    CountingResource served{nullptr};
+
+    // Heap bytes as of the last reset, to tell whether the round overflowed
+    long long heap_bytes_at_reset = 0;
+};
+
+// The resource the lists of the current round come from on this thread: the arena of the innermost
+// RoundScope, or the default resource outside of any
+std::pmr::memory_resource* round_resource();
+
+// Makes an arena the round resource of this thread while it lives, and resets the arena when it ends
+class RoundScope {
+public:
+    explicit RoundScope(RoundArena& arena);
+
+    ~RoundScope();
+
+    RoundScope(const RoundScope&) = delete;
+
+    RoundScope& operator=(const RoundScope&) = delete;
+
+private:
+    RoundArena& arena;
+    std::pmr::memory_resource* previous;
+};
+
+#endif //ANIMAL_WORLD_ROUND_ARENA_H
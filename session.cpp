@@ -0,0 +1,358 @@
+#include "session.h"
+#include "event_trace.h"
+#include "profiler.h"
+
+#include <iostream>
+#include <utility>
+
+using std::cerr;
+using std::endl;
+using std::string_view;
+
+// Makes a session's generator the one of the calling thread while it lives, and keeps what was drawn from it
+class EngineScope {
+public:
+    explicit EngineScope(GameEngine& engine) : engine{engine}, saved{generator} { generator = engine; }
+
+    ~EngineScope() {
+        engine = generator;
+        generator = saved;
+    }
+
+    EngineScope(const EngineScope&) = delete;
+
+    EngineScope& operator=(const EngineScope&) = delete;
+
+private:
+    GameEngine& engine;
+    GameEngine saved;
+};
+
+// Answers are matched on how they start, as the game always has: "yes" is a yes and "stones" is a stone
+static bool starts_with(string_view word, string_view prefix) {
+    return word.compare(0, prefix.size(), prefix) == 0;
+}
+
+static bool parse_card(string_view word, Card& card) {
+    for (int i = 0; i < 3; ++i) {
+        if (starts_with(word, verbose((Card) i))) {
+            card = (Card) i;
+            return true;
+        }
+    }
+    return false;
+}
+
+GameSession::GameSession(const SessionConfig& config, const std::vector<std::string_view>& names)
+        : config{config}, engine{config.seed}, actors{init_actors(config.actor_count, names)}, global{actors} {
+    global.seed = config.seed;
+    global.lookahead = config.lookahead;
+    standings_view.page_size = config.page_size;
+    frame << "Enter anything to start...\n";
+}
+
+GameSession::GameSession(const SessionConfig& config, const Snapshot& snapshot)
+        : config{config}, engine{snapshot.meta.generator}, actors{snapshot.restore_actors()},
+          global{actors, snapshot.counts, snapshot.restore_buckets()} {
+    // A game taken up again has been told the intro already
+    this->config.intro = nullptr;
+    player = snapshot.meta.player;
+    player.name = "Player";
+    round = (int) snapshot.meta.round;
+    global.round = round;
+    global.seed = snapshot.meta.seed;
+    global.lookahead = config.lookahead;
+    standings_view.page_size = config.page_size;
+    frame << "Enter anything to start...\n";
+}
+
+SessionStatus GameSession::status() const {
+    if (state == State::FINISHED) return SessionStatus::FINISHED;
+    return pending == Work::NONE ? SessionStatus::WAITING_INPUT : SessionStatus::WAITING_WORK;
+}
+
+void GameSession::input(string_view word) {
+    switch (state) {
+        case State::START:
+        case State::INTRO: {
+            size_t line = state == State::START ? 0 : intro_line + 1;
+            if (config.intro != nullptr && line < config.intro->size()) {
+                frame << (*config.intro)[line] << '\n';
+                intro_line = line;
+                state = State::INTRO;
+            } else {
+                pending = Work::BEGIN_ROUND;
+            }
+            break;
+        }
+        case State::COMPETE: {
+            if (paged && word == "more") {
+                PROFILE_PHASE(Phase::DISPLAY);
+                if (speculation) speculation->wait_copied();
+                ++standings_view.page;
+                render_standings(frame, global, standings_view);
+                prompt_compete();
+                break;
+            }
+
+            bool compete;
+            if (starts_with(word, "y")) {
+                compete = true;
+            } else if (starts_with(word, "n")) {
+                compete = false;
+            } else {
+                frame << R"(Please input "y" or "n")" << '\n';
+                prompt_compete();
+                break;
+            }
+
+            if (!player.can_compete()) {
+                frame << "You have no available cards. Try to negotiate with other competitors\n";
+                compete = false;
+            }
+
+            decision = {compete, Card::STONE};
+            if (compete) {
+                prompt_card();
+                state = State::CARD;
+            } else {
+                pending = Work::PLAY_ROUND;
+            }
+            break;
+        }
+        case State::CARD: {
+            Card card;
+            bool valid = parse_card(word, card);
+            if (!valid) frame << "Please enter correct card name\n";
+            if (valid && player.card_count(card) <= 0) {
+                frame << "You have no card of this type\n";
+                valid = false;
+            }
+
+            if (valid) {
+                decision.card = card;
+                pending = Work::PLAY_ROUND;
+            } else {
+                prompt_card();
+            }
+            break;
+        }
+        case State::MATCH_SHOWN:
+            after_match();
+            break;
+        case State::NEGOTIATE_ACTOR: {
+            negotiate_handle = {};
+            bool found = false;
+            for (ActorHandle handle : outcome.candidates) {
+                if (starts_with(word, actors[handle].name)) {
+                    negotiate_handle = handle;
+                    found = true;
+                    break;
+                }
+            }
+
+            if (!found) {
+                pending = Work::FINISH_ROUND;
+                break;
+            }
+            frame << "You are negotiating with " << actors[negotiate_handle].name << '\n';
+            frame << "What card do you want to give? [stone/scissor/paper]\n";
+            state = State::GIVE_CARD;
+            break;
+        }
+        case State::GIVE_CARD: {
+            auto& other = actors[negotiate_handle];
+            Card card;
+            if (parse_card(word, card)) {
+                if (player.card_count(card) <= 0)
+                    frame << "You cannot give this card\n";
+                else if (!can_receive_card(global, other, card))
+                    frame << other.name << " will not accept this card\n";
+                else {
+                    give_card(player, other, card);
+                    global.touch(negotiate_handle);
+                    frame << "You get rid of a card of " << verbose(card) << '\n';
+                }
+            } else {
+                frame << "Please enter correct card name\n";
+                frame << "Invalid card name, continuing...\n";
+            }
+
+            frame << "What card do you want to receive? [stone/scissor/paper]\n";
+            state = State::RECEIVE_CARD;
+            break;
+        }
+        case State::RECEIVE_CARD: {
+            auto& other = actors[negotiate_handle];
+            Card card;
+            if (parse_card(word, card)) {
+                if (!can_give_card(global, other, card))
+                    frame << other.name << " will not give this card to you\n";
+                else {
+                    give_card(other, player, card);
+                    global.touch(negotiate_handle);
+                    frame << "You get a card of " << verbose(card) << '\n';
+                }
+            } else {
+                frame << "Please enter correct card name\n";
+                frame << "Invalid card name, continuing...\n";
+            }
+
+            pending = Work::FINISH_ROUND;
+            break;
+        }
+        case State::ROUND_OVER:
+            ++round;
+            pending = Work::BEGIN_ROUND;
+            break;
+        case State::GAME_OVER:
+            state = State::FINISHED;
+            break;
+        case State::FINISHED:
+            break;
+    }
+}
+
+void GameSession::work() {
+    EngineScope engine_scope(engine);
+    RoundScope round_scope(arena);
+
+    while (pending != Work::NONE) {
+        auto next = pending;
+        pending = Work::NONE;
+        switch (next) {
+            case Work::BEGIN_ROUND:
+                begin_round();
+                break;
+            case Work::PLAY_ROUND:
+                play_round();
+                break;
+            case Work::FINISH_ROUND:
+                end_round();
+                break;
+            case Work::NONE:
+                break;
+        }
+    }
+}
+
+void GameSession::begin_round() {
+    if (round >= 20) {
+        size_t unfinished_count = 0;
+        for (auto& actor : actors) {
+            if (config.page_size > 0 && unfinished_count == config.page_size) break;
+            frame << actor.name << " doesn't finish the game and is eliminated\n";
+            ++unfinished_count;
+        }
+        if (unfinished_count < actors.size())
+            frame << "(" << actors.size() - unfinished_count << " more don't finish the game)\n";
+
+        frame << "You are eliminated.\n";
+        prompt_continue();
+        state = State::GAME_OVER;
+        return;
+    }
+
+    if (auto* channel = trace_channel()) channel->set_context(0, round);
+    profile_round(round);
+    {
+        PROFILE_PHASE(Phase::DISPLAY);
+        frame << "Round " << round + 1 << '\n';
+        render_counts(frame, global);
+        frame << '\n';
+        standings_view.page = 0;
+        paged = config.page_size > 0 && render_standings(frame, global, standings_view) > config.page_size;
+        frame << '\n';
+
+        frame << "Your status:\n";
+        frame << "Name\t\t" << "St\t" << "Sc\t" << "Pp\t\t" << "Stars\t\t";
+        frame << "Success Prob\t" << "Fail Prob\t" << '\n';
+        render_actor_all(frame, global, player);
+        if (config.policy) render_policy_advice(frame, config.policy->advise(global, player, round));
+        frame << '\n';
+    }
+
+    // Play the round for every answer the player may give while they think it over
+    if (config.speculate) speculation.emplace(global, player, config.page_size);
+
+    prompt_compete();
+    state = State::COMPETE;
+}
+
+void GameSession::play_round() {
+    outcome = RoundOutcome{std::pmr::new_delete_resource()};
+    if (speculation) speculation->commit(decision, global, player, outcome);
+    else play_round_ahead(global, player, decision, config.page_size, outcome);
+
+    if (decision.compete) {
+        render_player_match(frame, outcome.match);
+        prompt_continue();
+        state = State::MATCH_SHOWN;
+        return;
+    }
+    after_match();
+}
+
+void GameSession::after_match() {
+    if (outcome.player_check != CheckResult::CONTINUE) {
+        frame << (outcome.player_check == CheckResult::WIN ? "You are safe now!\n" : "You are eliminated!\n");
+        speculation.reset();
+        state = State::GAME_OVER;
+        return;
+    }
+
+    frame << outcome.results;
+
+    // A player who competed has no part in the negotiation
+    if (decision.compete) {
+        pending = Work::FINISH_ROUND;
+        return;
+    }
+
+    {
+        PROFILE_PHASE(Phase::DISPLAY);
+        frame << "People ready for negotiation:\n";
+        ListView view;
+        view.page_size = config.page_size;
+        render_actor_list(frame, actors, outcome.candidates, view);
+    }
+    frame << "Enter the name of the person you want to negotiate with; Enter anything else to yield...\n";
+    state = State::NEGOTIATE_ACTOR;
+}
+
+void GameSession::end_round() {
+    if (!outcome.finished) {
+        outcome.list = negotiate_list(outcome.candidates);
+        auto_negotiate(global, outcome.list);
+        finish_round(global);
+    }
+    speculation.reset();
+
+    if (!config.save_file.empty() && config.names != nullptr) {
+        SnapshotMeta meta;
+        meta.round = round + 1;
+        meta.seed = config.seed;
+        meta.generator = generator;
+        meta.has_player = true;
+        meta.player = player;
+        if (!save_snapshot(config.save_file, global, meta, *config.names))
+            cerr << "Cannot save the game to " << config.save_file << endl;
+    }
+
+    prompt_continue();
+    state = State::ROUND_OVER;
+}
+
+void GameSession::prompt_continue() {
+    frame << "\nEnter anything to continue...\n";
+}
+
+void GameSession::prompt_compete() {
+    frame << "Do you want to compete this round? [y/n]";
+    if (paged) frame << R"( Enter "more" for the next page of the standings)";
+    frame << '\n';
+}
+
+void GameSession::prompt_card() {
+    frame << "Which card do you want to use in this round? [stone/scissor/paper]\n";
+}
@@ -0,0 +1,136 @@
+#ifndef ANIMAL_WORLD_SESSION_H
+#define ANIMAL_WORLD_SESSION_H
+
+#include "game.h"
+#include "render.h"
+#include "speculation.h"
+#include "name_pool.h"
+#include "snapshot.h"
+#include "round_arena.h"
+#include "policy.h"
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <optional>
+#include <cstddef>
+
+struct SessionConfig {
+    int actor_count = 99;
+    unsigned seed = 9961;
+
+    // Actors listed a page; 0 lists them all
+    size_t page_size = 20;
+
+    // Play the round ahead for every answer while waiting for the player, see speculation.h
+    bool speculate = false;
+
+    // Decides for the NPCs it controls when set, see lookahead.h
+    Lookahead* lookahead = nullptr;
+
+    // Advises the player at the start of each round when set, see policy.h
+    const PolicyTable* policy = nullptr;
+
+    // Lines told before the first round, each waiting for a word; none when null
+    const std::vector<std::string>* intro = nullptr;
+
+    // Keep a snapshot of the game as of the next round here when set; names is the pool the actors were
+    // named from
+    std::string save_file;
+    const NamePool* names = nullptr;
+};
+
+enum class SessionStatus {
+    // input() takes the next word the player typed
+    WAITING_INPUT,
+    // work() plays what the session has to play before it can ask the player again
+    WAITING_WORK,
+    FINISHED,
+};
+
+// One player's game as a state machine, so that whoever drives it decides where its input comes from and where
+// its work runs. The player's words go in through input(), which only ever does the little the answer itself
+// takes; everything the NPCs play, and the screens that follow it, is left for work(). A session owns its
+// game, generator included, so work() may run on any thread, as long as it is one at a time. Both add to
+// output(), which holds exactly what the interactive game prints.
+class GameSession {
+public:
+    // A new game of config.actor_count actors, named from names
+    GameSession(const SessionConfig& config, const std::vector<std::string_view>& names);
+
+    // The game of a snapshot saved with a player
+    GameSession(const SessionConfig& config, const Snapshot& snapshot);
+
+    GameSession(const GameSession&) = delete;
+
+    GameSession& operator=(const GameSession&) = delete;
+
+    [[nodiscard]] SessionStatus status() const;
+
+    void input(std::string_view word);
+
+    void work();
+
+    // What the session printed since it was last presented
+    Frame& output() { return frame; }
+
+private:
+    enum class State {
+        START,
+        INTRO,
+        COMPETE,
+        CARD,
+        MATCH_SHOWN,
+        NEGOTIATE_ACTOR,
+        GIVE_CARD,
+        RECEIVE_CARD,
+        ROUND_OVER,
+        GAME_OVER,
+        FINISHED,
+    };
+
+    enum class Work {
+        NONE,
+        BEGIN_ROUND,
+        PLAY_ROUND,
+        FINISH_ROUND,
+    };
+
+    void begin_round();
+
+    void play_round();
+
+    void after_match();
+
+    void end_round();
+
+    void prompt_continue();
+
+    void prompt_compete();
+
+    void prompt_card();
+
+    SessionConfig config;
+
+    GameEngine engine;
+    ActorRegistry actors;
+    Global global;
+    Actor player{0, "Player", 2, 2, 2, 3};
+    int round = 0;
+    RoundArena arena;
+
+    State state = State::START;
+    Work pending = Work::NONE;
+    size_t intro_line = 0;
+
+    Frame frame;
+    ListView standings_view;
+    bool paged = false;
+
+    std::optional<RoundSpeculation> speculation;
+    PlayerDecision decision;
+    RoundOutcome outcome{std::pmr::new_delete_resource()};
+    ActorHandle negotiate_handle{};
+};
+
+#endif //ANIMAL_WORLD_SESSION_H
@@ -0,0 +1,440 @@
+#include "session_server.h"
+#include "thread_pool.h"
+
+#include <iostream>
+#include <fstream>
+#include <map>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <cstring>
+#include <cerrno>
+#include <cctype>
+#include <csignal>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+using std::cerr;
+using std::endl;
+using std::vector;
+using std::string;
+
+static volatile std::sig_atomic_t stop_requested = 0;
+
+static void request_stop(int) {
+    stop_requested = 1;
+}
+
+// One player: their session, the words they typed that it has not taken yet, and what it printed that has not
+// reached them yet
+struct Connection {
+    std::unique_ptr<GameSession> session;
+
+    // The player's socket, or -1 for a script, whose output goes to its transcript instead
+    int fd = -1;
+    std::ofstream transcript;
+
+    std::deque<string> words;
+    string partial_word;
+    string outgoing;
+    bool input_closed = false;
+
+    // A worker is playing the session, and nothing else may touch it until it is done
+    bool working = false;
+    bool finished = false;
+};
+
+class SessionServer {
+public:
+    SessionServer(const ServerConfig& config, const vector<std::string_view>& names);
+
+    ~SessionServer();
+
+    SessionServer(const SessionServer&) = delete;
+
+    SessionServer& operator=(const SessionServer&) = delete;
+
+    bool run();
+
+private:
+    bool open_socket();
+
+    bool open_script(const string& filename);
+
+    std::unique_ptr<Connection> new_connection();
+
+    void accept_players();
+
+    void read_input(Connection& connection);
+
+    void write_output(Connection& connection);
+
+    // Feed the session the words it has, until it waits for more or for a worker
+    void pump(uint64_t id, Connection& connection);
+
+    void take_finished_work();
+
+    void stop();
+
+    const ServerConfig& config;
+    const vector<std::string_view>& names;
+    unsigned session_count = 0;
+
+    int listen_fd = -1;
+    // Workers write a byte here when they finish, to wake the loop from poll
+    int wake_fds[2] = {-1, -1};
+
+    std::map<uint64_t, std::unique_ptr<Connection>> connections;
+    uint64_t next_id = 0;
+
+    std::mutex done_mutex;
+    vector<uint64_t> done_ids;
+
+    // Last, so that it finishes its tasks before anything they touch goes away
+    TaskQueue workers;
+};
+
+SessionServer::SessionServer(const ServerConfig& config, const vector<std::string_view>& names)
+        : config{config}, names{names}, workers{config.thread_count} {}
+
+SessionServer::~SessionServer() {
+    if (listen_fd >= 0) {
+        close(listen_fd);
+        unlink(config.socket_path.c_str());
+    }
+    for (int fd : wake_fds)
+        if (fd >= 0) close(fd);
+}
+
+bool SessionServer::open_socket() {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (config.socket_path.size() >= sizeof(address.sun_path)) {
+        cerr << "Socket path too long: " << config.socket_path << endl;
+        return false;
+    }
+    strcpy(address.sun_path, config.socket_path.c_str());
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    // A socket file left behind by an earlier server would fail the bind
+    unlink(config.socket_path.c_str());
+    if (listen_fd < 0 || bind(listen_fd, (const sockaddr*) &address, sizeof(address)) != 0 ||
+        listen(listen_fd, SOMAXCONN) != 0) {
+        cerr << "Cannot listen on " << config.socket_path << ": " << strerror(errno) << endl;
+        return false;
+    }
+    return true;
+}
+
+std::unique_ptr<Connection> SessionServer::new_connection() {
+    SessionConfig session_config = config.session;
+    session_config.seed += session_count++;
+
+    auto connection = std::make_unique<Connection>();
+    connection->session = std::make_unique<GameSession>(session_config, names);
+    return connection;
+}
+
+bool SessionServer::open_script(const string& filename) {
+    std::ifstream fs{filename};
+    if (!fs) {
+        cerr << "Cannot read the script " << filename << endl;
+        return false;
+    }
+
+    std::ofstream transcript{filename + ".out"};
+    if (!transcript) {
+        cerr << "Cannot write the transcript of " << filename << endl;
+        return false;
+    }
+
+    auto connection = new_connection();
+    connection->transcript = std::move(transcript);
+    string word;
+    while (fs >> word)
+        connection->words.push_back(word);
+    connection->input_closed = true;
+
+    uint64_t id = next_id++;
+    auto& added = *connections.emplace(id, std::move(connection)).first->second;
+    pump(id, added);
+    return true;
+}
+
+void SessionServer::accept_players() {
+    while (true) {
+        int fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+
+        auto connection = new_connection();
+        connection->fd = fd;
+        uint64_t id = next_id++;
+        auto& added = *connections.emplace(id, std::move(connection)).first->second;
+        pump(id, added);
+    }
+}
+
+void SessionServer::read_input(Connection& connection) {
+    char buffer[4096];
+    while (true) {
+        ssize_t count = recv(connection.fd, buffer, sizeof(buffer), 0);
+        if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        if (count < 0 && errno == EINTR) continue;
+
+        // Words are split on white space, as std::cin would
+        for (ssize_t i = 0; i < count; ++i) {
+            if (isspace((unsigned char) buffer[i])) {
+                if (!connection.partial_word.empty()) connection.words.push_back(std::move(connection.partial_word));
+                connection.partial_word.clear();
+            } else {
+                connection.partial_word.push_back(buffer[i]);
+            }
+        }
+
+        if (count <= 0) {
+            if (!connection.partial_word.empty()) connection.words.push_back(std::move(connection.partial_word));
+            connection.partial_word.clear();
+            connection.input_closed = true;
+            return;
+        }
+    }
+}
+
+void SessionServer::write_output(Connection& connection) {
+    size_t written = 0;
+    while (written < connection.outgoing.size()) {
+        ssize_t count = send(connection.fd, connection.outgoing.data() + written, connection.outgoing.size() - written,
+                             MSG_NOSIGNAL);
+        if (count > 0) {
+            written += count;
+        } else if (count < 0 && errno == EINTR) {
+            continue;
+        } else if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            // The player is gone; the session ends at its next question
+            connection.outgoing.clear();
+            connection.words.clear();
+            connection.input_closed = true;
+            return;
+        }
+    }
+    connection.outgoing.erase(0, written);
+}
+
+void SessionServer::pump(uint64_t id, Connection& connection) {
+    auto& session = *connection.session;
+    while (!connection.working && !connection.finished) {
+        auto& output = session.output();
+        if (connection.fd < 0) connection.transcript << output.text();
+        else connection.outgoing.append(output.text());
+        output.clear();
+
+        auto status = session.status();
+        if (status == SessionStatus::FINISHED) {
+            connection.finished = true;
+        } else if (status == SessionStatus::WAITING_WORK) {
+            connection.working = true;
+            workers.push([this, id, &session] {
+                session.work();
+                {
+                    std::lock_guard<std::mutex> lock(done_mutex);
+                    done_ids.push_back(id);
+                }
+                char byte = 0;
+                while (write(wake_fds[1], &byte, 1) < 0 && errno == EINTR) {}
+            });
+        } else if (!connection.words.empty()) {
+            session.input(connection.words.front());
+            connection.words.pop_front();
+        } else {
+            if (connection.input_closed) connection.finished = true;
+            break;
+        }
+    }
+
+    if (connection.fd >= 0) write_output(connection);
+}
+
+void SessionServer::take_finished_work() {
+    char buffer[256];
+    while (read(wake_fds[0], buffer, sizeof(buffer)) > 0) {}
+
+    vector<uint64_t> ids;
+    {
+        std::lock_guard<std::mutex> lock(done_mutex);
+        ids.swap(done_ids);
+    }
+    for (uint64_t id : ids) {
+        auto& connection = *connections.at(id);
+        connection.working = false;
+        pump(id, connection);
+    }
+}
+
+void SessionServer::stop() {
+    if (listen_fd >= 0) {
+        close(listen_fd);
+        unlink(config.socket_path.c_str());
+        listen_fd = -1;
+    }
+
+    // Sessions end at their next question, and nobody is left to read what they print
+    for (auto& [id, connection] : connections) {
+        connection->words.clear();
+        connection->input_closed = true;
+        if (connection->fd >= 0) {
+            shutdown(connection->fd, SHUT_RDWR);
+            connection->outgoing.clear();
+        }
+        pump(id, *connection);
+        connection->outgoing.clear();
+    }
+}
+
+bool SessionServer::run() {
+    if (pipe2(wake_fds, O_NONBLOCK | O_CLOEXEC) != 0) {
+        cerr << "Cannot create a pipe: " << strerror(errno) << endl;
+        return false;
+    }
+    if (!config.socket_path.empty()) {
+        if (!open_socket()) return false;
+        signal(SIGINT, request_stop);
+        signal(SIGTERM, request_stop);
+    }
+    for (auto& script : config.scripts)
+        open_script(script);
+
+    auto start = std::chrono::steady_clock::now();
+    vector<pollfd> fds;
+    vector<uint64_t> fd_ids;
+    bool stopping = false;
+    while (true) {
+        if (stop_requested && !stopping) {
+            stopping = true;
+            stop();
+        }
+
+        for (auto it = connections.begin(); it != connections.end();) {
+            auto& connection = *it->second;
+            if (connection.finished && !connection.working && connection.outgoing.empty()) {
+                if (connection.fd >= 0) close(connection.fd);
+                it = connections.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        if (listen_fd < 0 && connections.empty()) break;
+
+        fds.clear();
+        fd_ids.clear();
+        fds.push_back({wake_fds[0], POLLIN, 0});
+        if (listen_fd >= 0) fds.push_back({listen_fd, POLLIN, 0});
+        size_t first_connection = fds.size();
+        for (auto& [id, connection] : connections) {
+            if (connection->fd < 0) continue;
+            short events = 0;
+            if (!connection->input_closed) events |= POLLIN;
+            if (!connection->outgoing.empty()) events |= POLLOUT;
+            fds.push_back({connection->fd, events, 0});
+            fd_ids.push_back(id);
+        }
+
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            cerr << "poll failed: " << strerror(errno) << endl;
+            return false;
+        }
+
+        if (fds[0].revents & POLLIN) take_finished_work();
+        if (listen_fd >= 0 && (fds[1].revents & POLLIN)) accept_players();
+        for (size_t i = first_connection; i < fds.size(); ++i) {
+            if (fds[i].revents == 0) continue;
+            uint64_t id = fd_ids[i - first_connection];
+            auto& connection = *connections.at(id);
+            if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+                read_input(connection);
+                pump(id, connection);
+            }
+            if (fds[i].revents & POLLOUT) write_output(connection);
+        }
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    cerr << "Played " << session_count << " sessions in " << elapsed.count() << " s" << endl;
+    return true;
+}
+
+bool serve(const ServerConfig& config, const vector<std::string_view>& names) {
+    SessionServer server(config, names);
+    return server.run();
+}
+
+static void server_usage() {
+    cerr << "Usage: animal_world --serve [--socket PATH] [--script FILE]... [--threads N] [--actors N] [--top N]"
+         << " [--seed N] [--names FILE] [--intro FILE] [--policy FILE]" << endl;
+}
+
+int run_server(int argc, char** argv) {
+    ServerConfig config;
+    string names_file = "names.txt";
+    string intro_file = "intro.txt";
+    string policy_file;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+        if (strcmp(arg, "--serve") == 0) continue;
+        if (value == nullptr) {
+            server_usage();
+            return 1;
+        }
+
+        if (strcmp(arg, "--socket") == 0) config.socket_path = value;
+        else if (strcmp(arg, "--script") == 0) config.scripts.emplace_back(value);
+        else if (strcmp(arg, "--threads") == 0) config.thread_count = std::stoi(value);
+        else if (strcmp(arg, "--actors") == 0) config.session.actor_count = std::stoi(value);
+        else if (strcmp(arg, "--top") == 0) config.session.page_size = std::stoul(value);
+        else if (strcmp(arg, "--seed") == 0) config.session.seed = (unsigned) std::stoul(value);
+        else if (strcmp(arg, "--names") == 0) names_file = value;
+        else if (strcmp(arg, "--intro") == 0) intro_file = value;
+        else if (strcmp(arg, "--policy") == 0) policy_file = value;
+        else {
+            server_usage();
+            return 1;
+        }
+        ++i;
+    }
+    if (config.socket_path.empty() && config.scripts.empty()) {
+        server_usage();
+        return 1;
+    }
+
+    NamePool names(names_file);
+    auto session_names = names.first(config.session.actor_count);
+
+    vector<string> intro;
+    std::ifstream fs{intro_file};
+    string line;
+    while (getline(fs, line))
+        intro.push_back(line);
+    config.session.intro = &intro;
+
+    // Every session reads the one mapping
+    std::unique_ptr<PolicyTable> policy;
+    if (!policy_file.empty()) {
+        policy = std::make_unique<PolicyTable>(policy_file);
+        if (!policy->is_open() || !policy->shape().fits(Rules{}, 20)) {
+            cerr << "Cannot read a policy table for this game from " << policy_file << endl;
+            return 1;
+        }
+        config.session.policy = policy.get();
+    }
+
+    return serve(config, session_names) ? 0 : 1;
+}
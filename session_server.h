@@ -0,0 +1,32 @@
+#ifndef ANIMAL_WORLD_SESSION_SERVER_H
+#define ANIMAL_WORLD_SESSION_SERVER_H
+
+#include "session.h"
+
+#include <string>
+#include <vector>
+
+struct ServerConfig {
+    // Every session is configured alike, except that the k-th session to start is seeded with seed + k
+    SessionConfig session;
+
+    // Accept players on this Unix-domain socket when set
+    std::string socket_path;
+
+    // Play one session for each of these files, reading the player's words from it and writing what the
+    // player would see to the file with ".out" appended
+    std::vector<std::string> scripts;
+
+    // Workers for what sessions play between answers; zero means one per hardware thread
+    int thread_count = 0;
+};
+
+// Host every session in one process. A single thread waits for input on all of them at once and hands a session
+// to the workers only when an answer leaves it something to play, so an idle player costs no thread. Returns
+// once the scripts are done and, with a socket, on SIGINT or SIGTERM.
+bool serve(const ServerConfig& config, const std::vector<std::string_view>& names);
+
+// Entry point of `animal_world --serve ...`
+int run_server(int argc, char** argv);
+
+#endif //ANIMAL_WORLD_SESSION_SERVER_H
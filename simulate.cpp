@@ -0,0 +1,447 @@
+#include "simulate.h"
+#include "game.h"
+#include "thread_pool.h"
+#include "hand_class.h"
+#include "name_pool.h"
+#include "compete_ranking.h"
+#include "round_arena.h"
+#include "snapshot.h"
+#include "event_trace.h"
+#include "lookahead.h"
+#include "strategy.h"
+
+#include <iostream>
+#include <chrono>
+#include <memory>
+#include <cstring>
+#include <type_traits>
+#include <algorithm>
+#include <numeric>
+#include <climits>
+
+using std::cout;
+using std::cerr;
+using std::endl;
+using std::vector;
+using std::string;
+
+void SimulationSummary::add(const GameResult& result) {
+    ++game_count;
+    safe_count += result.safe_count;
+    eliminated_count += result.eliminated_count;
+    unfinished_count += result.unfinished_count;
+
+    if ((int) safe_histogram.size() <= result.safe_count)
+        safe_histogram.resize(result.safe_count + 1);
+    ++safe_histogram[result.safe_count];
+
+    if (by_strategy.size() < result.by_strategy.size()) by_strategy.resize(result.by_strategy.size());
+    for (size_t i = 0; i < result.by_strategy.size(); ++i) {
+        by_strategy[i].actor_count += result.by_strategy[i].actor_count;
+        by_strategy[i].safe_count += result.by_strategy[i].safe_count;
+        by_strategy[i].eliminated_count += result.by_strategy[i].eliminated_count;
+        by_strategy[i].unfinished_count += result.by_strategy[i].unfinished_count;
+    }
+}
+
+void SimulationSummary::merge(const SimulationSummary& other) {
+    game_count += other.game_count;
+    safe_count += other.safe_count;
+    eliminated_count += other.eliminated_count;
+    unfinished_count += other.unfinished_count;
+
+    if (safe_histogram.size() < other.safe_histogram.size())
+        safe_histogram.resize(other.safe_histogram.size());
+    for (size_t i = 0; i < other.safe_histogram.size(); ++i)
+        safe_histogram[i] += other.safe_histogram[i];
+
+    if (by_strategy.size() < other.by_strategy.size()) by_strategy.resize(other.by_strategy.size());
+    for (size_t i = 0; i < other.by_strategy.size(); ++i) {
+        by_strategy[i].actor_count += other.by_strategy[i].actor_count;
+        by_strategy[i].safe_count += other.by_strategy[i].safe_count;
+        by_strategy[i].eliminated_count += other.by_strategy[i].eliminated_count;
+        by_strategy[i].unfinished_count += other.by_strategy[i].unfinished_count;
+    }
+}
+
+void SimulationSummary::display(const SimulationConfig& config, double seconds) const {
+    double actor_total = (double) game_count * config.actor_count;
+    if (actor_total == 0) actor_total = 1;
+
+    cout << "Games: " << game_count << endl;
+    cout << "Actors per game: " << config.actor_count << endl;
+    cout << "Rounds per game: " << config.round_count << endl;
+    cout << "Safe rate: " << (double) safe_count / actor_total << endl;
+    cout << "Eliminated rate: " << (double) eliminated_count / actor_total << endl;
+    cout << "Unfinished rate: " << (double) unfinished_count / actor_total << endl;
+    cout << endl;
+
+    cout << "Safe\t" << "Games" << endl;
+    for (size_t i = 0; i < safe_histogram.size(); ++i)
+        if (safe_histogram[i] > 0) cout << i << '\t' << safe_histogram[i] << endl;
+    cout << endl;
+
+    if (!by_strategy.empty()) {
+        cout << "Strategy\t" << "Actors\t" << "Safe\t" << "Eliminated\t" << "Unfinished" << endl;
+        for (size_t i = 0; i < by_strategy.size(); ++i) {
+            auto& group = by_strategy[i];
+            if (group.actor_count == 0) continue;
+            auto actors = (double) group.actor_count;
+            cout << strategy_names[i] << '\t' << config.strategy_counts[i] << '\t'
+                 << (double) group.safe_count / actors << '\t' << (double) group.eliminated_count / actors << '\t'
+                 << (double) group.unfinished_count / actors << endl;
+        }
+        cout << endl;
+    }
+
+    cout << "Elapsed: " << seconds << " s (" << (double) game_count / seconds << " games/s)" << endl;
+}
+
+// The compete phase, split over the pool when there is one. Only the game's own heuristic chooses cards on a
+// pool, so other strategies always play the phase on the calling thread.
+static void compete_phase(Global& global, const HandleList& list, ThreadPool* pool, unsigned seed, int round,
+                          const DefaultStrategy& strategy) {
+    if (pool != nullptr) auto_compete_parallel(global, list, *pool, seed, (uint32_t) round);
+    else auto_compete(global, list, strategy);
+}
+
+template<typename Strategy>
+static void compete_phase(Global& global, const HandleList& list, ThreadPool*, unsigned, int,
+                          const Strategy& strategy) {
+    auto_compete(global, list, strategy);
+}
+
+// Play rounds [first_round, end_round) of a game, or until nobody is left
+template<typename Strategy>
+static void play_rounds(Global& global, GameResult& result, unsigned seed, ThreadPool* pool, int first_round,
+                        int end_round, const Strategy& strategy, vector<long long>* eliminated_by_round = nullptr) {
+    auto& actors = global.actors;
+
+    // One arena per thread serves every game it plays, so it is sized by the first few rounds and reused
+    thread_local RoundArena arena;
+    for (int round = first_round; round < end_round && !actors.empty(); ++round) {
+        RoundScope round_scope(arena);
+        if (auto* channel = trace_channel()) channel->set_context(seed, (uint32_t) round);
+        profile_round(round);
+        auto list = compete_list(global, strategy);
+        compete_phase(global, list, pool, seed, round, strategy);
+
+        global.refresh();
+        result.safe_count += (int) global.safe_actors.size();
+        result.eliminated_count += (int) global.eliminated_actors.size();
+        if (eliminated_by_round != nullptr) {
+            if ((int) eliminated_by_round->size() <= round) eliminated_by_round->resize(round + 1);
+            (*eliminated_by_round)[round] += (long long) global.eliminated_actors.size();
+        }
+        if constexpr (std::is_same_v<Strategy, Tournament>) {
+            for (auto handle : global.safe_actors)
+                ++result.by_strategy[strategy.group_of(actors[handle])].safe_count;
+            for (auto handle : global.eliminated_actors)
+                ++result.by_strategy[strategy.group_of(actors[handle])].eliminated_count;
+        }
+        remove_actors(global);
+
+        auto candidates = negotiate_candidates(global, list);
+        list = negotiate_list(candidates);
+        if (pool != nullptr) auto_negotiate_parallel(global, list, *pool, strategy);
+        else auto_negotiate(global, list, strategy);
+        finish_round(global);
+    }
+}
+
+// play_rounds by the game's own strategy, or by a tournament of config.strategy_counts
+static void play_game_rounds(const SimulationConfig& config, Global& global, GameResult& result, unsigned seed,
+                             ThreadPool* pool, int first_round, int end_round,
+                             vector<long long>* eliminated_by_round = nullptr) {
+    if (config.strategy_counts.empty()) {
+        play_rounds(global, result, seed, pool, first_round, end_round, DefaultStrategy{}, eliminated_by_round);
+        return;
+    }
+
+    std::array<int, Tournament::group_count> counts{};
+    std::copy(config.strategy_counts.begin(), config.strategy_counts.end(), counts.begin());
+    Tournament tournament(counts);
+
+    result.by_strategy.assign(Tournament::group_count, StrategyResult{});
+    for (auto& actor : global.actors)
+        ++result.by_strategy[tournament.group_of(actor)].actor_count;
+    play_rounds(global, result, seed, nullptr, first_round, end_round, tournament, eliminated_by_round);
+    for (auto& actor : global.actors)
+        ++result.by_strategy[tournament.group_of(actor)].unfinished_count;
+}
+
+GameResult simulate_game(const SimulationConfig& config, const vector<std::string_view>& names, unsigned seed,
+                         ThreadPool* pool, const Snapshot* start, vector<long long>* eliminated_by_round) {
+    GameResult result{0, 0, 0};
+
+    if (start != nullptr) {
+        if (seed == start->meta.seed) generator = start->meta.generator;
+        else generator.seed(seed);
+
+        auto actors = start->restore_actors();
+        Global global(actors, start->counts, start->restore_buckets(), config.rules);
+        global.round = (int) start->meta.round;
+        global.seed = seed;
+        global.lookahead = config.lookahead;
+        play_game_rounds(config, global, result, seed, pool, (int) start->meta.round, config.round_count,
+                         eliminated_by_round);
+        result.unfinished_count = (int) actors.size();
+        return result;
+    }
+
+    generator.seed(seed);
+    auto actors = init_actors(config.actor_count, names, config.rules);
+    Global global(actors, config.rules);
+    global.seed = seed;
+    global.lookahead = config.lookahead;
+    play_game_rounds(config, global, result, seed, pool, 0, config.round_count, eliminated_by_round);
+    result.unfinished_count = (int) actors.size();
+    return result;
+}
+
+// Play the game of config.seed_begin up to the start of round and save it there
+static bool save_checkpoint(const SimulationConfig& config, const NamePool& pool, const string& filename,
+                            int round) {
+    unsigned seed = config.seed_begin;
+    generator.seed(seed);
+
+    auto actors = init_actors(config.actor_count, pool.first(config.actor_count), config.rules);
+    Global global(actors, config.rules);
+    global.seed = seed;
+    global.lookahead = config.lookahead;
+
+    GameResult result{0, 0, 0};
+    play_game_rounds(config, global, result, seed, nullptr, 0, round);
+
+    SnapshotMeta meta;
+    meta.round = (uint32_t) round;
+    meta.seed = seed;
+    meta.generator = generator;
+    return save_snapshot(filename, global, meta, pool);
+}
+
+SimulationSummary simulate(const SimulationConfig& config, const vector<std::string_view>& names,
+                           const Snapshot* start) {
+    ThreadPool pool(config.thread_count);
+    vector<SimulationSummary> summaries(pool.size());
+
+    // Worker w records into channel w, whether it plays whole games or helps with the phases of one
+    std::unique_ptr<EventTrace> trace;
+    if (!config.trace_file.empty()) {
+        trace = std::make_unique<EventTrace>(config.trace_file, pool.size());
+        if (!trace->is_open()) cerr << "Cannot write a trace to " << config.trace_file << endl;
+    }
+    auto trace_channel_of = [&](int worker) { return trace ? &trace->channel(worker) : nullptr; };
+
+    // Each worker profiles the games it plays, and the profiles are added up at the end
+    vector<Profiler> profilers(pool.size());
+    auto profiler_of = [&](int worker) { return config.profile_file.empty() ? nullptr : &profilers[worker]; };
+    auto write_profile = [&]() {
+        if (config.profile_file.empty()) return;
+        for (int worker = 1; worker < pool.size(); ++worker)
+            profilers[0].merge(profilers[worker]);
+        if (!profilers[0].write_json(config.profile_file))
+            cerr << "Cannot write the profile to " << config.profile_file << endl;
+    };
+
+    size_t game_count = config.seed_end > config.seed_begin ? config.seed_end - config.seed_begin : 0;
+    if (config.parallel_phases && config.engine == Engine::ACTOR) {
+        TraceScope trace_scope(trace_channel_of(0));
+        ProfilerScope profiler_scope(profiler_of(0));
+        for (size_t index = 0; index < game_count; ++index)
+            summaries[0].add(simulate_game(config, names, config.seed_begin + (unsigned) index, &pool, start));
+        write_profile();
+        return summaries[0];
+    }
+
+    pool.parallel_for(game_count, [&](size_t index, int worker) {
+        unsigned seed = config.seed_begin + (unsigned) index;
+        TraceScope trace_scope(trace_channel_of(worker));
+        ProfilerScope profiler_scope(profiler_of(worker));
+        auto result = config.engine == Engine::HAND_CLASS ? simulate_hand_class_game(config, seed)
+                                                          : simulate_game(config, names, seed, nullptr, start);
+        summaries[worker].add(result);
+    }, 64);
+
+    write_profile();
+
+    SimulationSummary summary;
+    for (auto& partial : summaries)
+        summary.merge(partial);
+    return summary;
+}
+
+// NAME=COUNT,... into the actors playing each strategy of a Tournament, in its order
+static bool parse_strategies(const string& text, vector<int>& counts) {
+    counts.assign(Tournament::group_count, 0);
+    size_t begin = 0;
+    while (begin <= text.size()) {
+        size_t end = text.find(',', begin);
+        if (end == string::npos) end = text.size();
+        string entry = text.substr(begin, end - begin);
+        begin = end + 1;
+
+        size_t equals = entry.find('=');
+        if (equals == string::npos) return false;
+        auto name = std::string_view(entry).substr(0, equals);
+        auto found = std::find(strategy_names.begin(), strategy_names.end(), name);
+        if (found == strategy_names.end()) return false;
+
+        int count = std::stoi(entry.substr(equals + 1));
+        if (count < 0) return false;
+        counts[found - strategy_names.begin()] += count;
+    }
+    return true;
+}
+
+bool card_counts_fit(const SimulationConfig& config) {
+    auto& rules = config.rules;
+    long long hand = (long long) rules.stone_count + rules.scissor_count + rules.paper_count;
+    return (long long) config.actor_count * hand <= INT_MAX;
+}
+
+static void simulation_usage() {
+    cerr << "Usage: animal_world --simulate [--engine actor|class] [--actors N] [--rounds N]"
+         << " [--seeds BEGIN:END | --games N] [--threads N] [--parallel-phases]"
+         << " [--names FILE] [--save-name-index] [--snapshot FILE | --save-snapshot FILE --snapshot-round N]"
+         << " [--trace FILE] [--profile FILE] [--lookahead N [--lookahead-budget US] [--lookahead-rollouts N]]"
+         << " [--strategies NAME=COUNT,...]" << endl;
+    cerr << "Strategies: heuristic, uniform, greedy, cautious" << endl;
+}
+
+int run_simulation(int argc, char** argv) {
+    SimulationConfig config;
+    unsigned game_count = 0;
+    string names_file = "names.txt";
+    bool save_name_index = false;
+    string snapshot_file;
+    string save_snapshot_file;
+    int snapshot_round = -1;
+    LookaheadConfig lookahead_config;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+        if (strcmp(arg, "--simulate") == 0) continue;
+        if (strcmp(arg, "--save-name-index") == 0) {
+            save_name_index = true;
+            continue;
+        }
+        if (strcmp(arg, "--parallel-phases") == 0) {
+            config.parallel_phases = true;
+            continue;
+        }
+        if (value == nullptr) {
+            simulation_usage();
+            return 1;
+        }
+
+        if (strcmp(arg, "--engine") == 0) {
+            if (strcmp(value, "actor") == 0) config.engine = Engine::ACTOR;
+            else if (strcmp(value, "class") == 0) config.engine = Engine::HAND_CLASS;
+            else {
+                simulation_usage();
+                return 1;
+            }
+        } else if (strcmp(arg, "--actors") == 0) config.actor_count = std::stoi(value);
+        else if (strcmp(arg, "--rounds") == 0) config.round_count = std::stoi(value);
+        else if (strcmp(arg, "--threads") == 0) config.thread_count = std::stoi(value);
+        else if (strcmp(arg, "--names") == 0) names_file = value;
+        else if (strcmp(arg, "--trace") == 0) config.trace_file = value;
+        else if (strcmp(arg, "--profile") == 0) config.profile_file = value;
+        else if (strcmp(arg, "--snapshot") == 0) snapshot_file = value;
+        else if (strcmp(arg, "--save-snapshot") == 0) save_snapshot_file = value;
+        else if (strcmp(arg, "--snapshot-round") == 0) snapshot_round = std::stoi(value);
+        else if (strcmp(arg, "--lookahead") == 0) lookahead_config.actor_count = std::stoi(value);
+        else if (strcmp(arg, "--lookahead-budget") == 0)
+            lookahead_config.budget = std::chrono::microseconds(std::stoll(value));
+        else if (strcmp(arg, "--lookahead-rollouts") == 0) lookahead_config.max_rollouts = std::stoi(value);
+        else if (strcmp(arg, "--strategies") == 0) {
+            if (!parse_strategies(value, config.strategy_counts)) {
+                simulation_usage();
+                return 1;
+            }
+        } else if (strcmp(arg, "--games") == 0) game_count = std::stoul(value);
+        else if (strcmp(arg, "--seeds") == 0) {
+            const char* colon = strchr(value, ':');
+            if (colon == nullptr) {
+                simulation_usage();
+                return 1;
+            }
+            config.seed_begin = std::stoul(string(value, colon));
+            config.seed_end = std::stoul(string(colon + 1));
+        } else {
+            simulation_usage();
+            return 1;
+        }
+        ++i;
+    }
+    if (game_count > 0) config.seed_end = config.seed_begin + game_count;
+    // A tournament is as many actors as its strategies have
+    if (!config.strategy_counts.empty())
+        config.actor_count = std::accumulate(config.strategy_counts.begin(), config.strategy_counts.end(), 0);
+    if (!config.profile_file.empty() && !Profiler::enabled())
+        cerr << "Profiling is not built in; configure with -DANIMAL_WORLD_PROFILE=ON" << endl;
+
+    if (config.actor_count <= 0 || config.round_count < 0 || !card_counts_fit(config) || save_snapshot_file.empty() != (snapshot_round < 0) ||
+        (!snapshot_file.empty() && (!save_snapshot_file.empty() || config.engine != Engine::ACTOR)) ||
+        (lookahead_config.actor_count > 0 && config.engine != Engine::ACTOR) || lookahead_config.max_rollouts <= 0 ||
+        (!config.strategy_counts.empty() && (config.engine != Engine::ACTOR || config.parallel_phases))) {
+        simulation_usage();
+        return 1;
+    }
+
+    // Games only need as many names as actors, so a huge pool is never scanned in full
+    NamePool pool;
+    vector<std::string_view> names;
+    if (config.engine == Engine::ACTOR || save_name_index || !save_snapshot_file.empty()) {
+        pool = NamePool(names_file);
+        if (!pool.is_open()) cerr << "Cannot open " << names_file << ", actors stay nameless" << endl;
+        if (save_name_index && !pool.save_index()) cerr << "Cannot save the index of " << names_file << endl;
+        names = pool.first(config.actor_count);
+    }
+
+    // Decisions share one pool of rollout threads, whichever game they are made in, and the
+    // rounds played up to a checkpoint are decided as simulate_game would decide them
+    std::unique_ptr<Lookahead> lookahead;
+    if (lookahead_config.actor_count > 0) {
+        lookahead_config.round_count = config.round_count;
+        lookahead = std::make_unique<Lookahead>(lookahead_config);
+        config.lookahead = lookahead.get();
+    }
+
+    if (!save_snapshot_file.empty()) {
+        if (!save_checkpoint(config, pool, save_snapshot_file, snapshot_round)) {
+            cerr << "Cannot save a snapshot to " << save_snapshot_file << endl;
+            return 1;
+        }
+        cout << "Saved game " << config.seed_begin << " at round " << snapshot_round << " to "
+             << save_snapshot_file << endl;
+        return 0;
+    }
+
+    // Every game starts where the snapshot left off, and rates are over the actors still in it
+    Snapshot snapshot;
+    if (!snapshot_file.empty()) {
+        auto load_start = std::chrono::steady_clock::now();
+        if (!load_snapshot(snapshot_file, pool, snapshot)) {
+            cerr << "Cannot load a snapshot from " << snapshot_file << endl;
+            return 1;
+        }
+        std::chrono::duration<double> load_elapsed = std::chrono::steady_clock::now() - load_start;
+        if (snapshot.meta.names_file != pool.path())
+            cerr << "The snapshot was saved with names from " << snapshot.meta.names_file << endl;
+        cout << "Loaded " << snapshot.size() << " actors at round " << snapshot.meta.round << " in "
+             << load_elapsed.count() * 1000 << " ms" << endl;
+        config.actor_count = (int) snapshot.size();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto summary = simulate(config, names, snapshot_file.empty() ? nullptr : &snapshot);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    summary.display(config, elapsed.count());
+    if (lookahead) display_lookahead_stats(lookahead->stats());
+    return 0;
+}
@@ -0,0 +1,107 @@
+#ifndef ANIMAL_WORLD_SIMULATE_H
+#define ANIMAL_WORLD_SIMULATE_H
+
+#include "game.h"
+
+#include <vector>
+#include <string>
+#include <string_view>
+
+enum class Engine {
+    // Every actor is stored and played one by one
+    ACTOR,
+    // Actors with the same hand are counted together, see hand_class.h
+    HAND_CLASS,
+};
+
+struct SimulationConfig {
+    Engine engine = Engine::ACTOR;
+
+    int actor_count = 99;
+    int round_count = 20;
+    Rules rules;
+
+    // Games are played for every seed in [seed_begin, seed_end)
+    unsigned seed_begin = 0;
+    unsigned seed_end = 1000;
+
+    // Zero means one thread per hardware thread
+    int thread_count = 0;
+
+    // Play games one at a time and split the phases of each game over the threads instead;
+    // pays off for few games with many actors
+    bool parallel_phases = false;
+
+    // Record every event of every game here when set, see event_trace.h
+    std::string trace_file;
+
+    // Write the time and counters of each phase here when set, see profiler.h
+    std::string profile_file;
+
+    // Decides for the NPCs it controls when set, see lookahead.h; the actor engine only
+    Lookahead* lookahead = nullptr;
+
+    // Actors playing each strategy of a Tournament, in its order, when set, see strategy.h. They add up to
+    // actor_count. The actor engine only, with its phases played on one thread.
+    std::vector<int> strategy_counts;
+};
+
+// How the actors of one strategy fared
+struct StrategyResult {
+    long long actor_count = 0;
+    long long safe_count = 0;
+    long long eliminated_count = 0;
+    long long unfinished_count = 0;
+};
+
+struct GameResult {
+    int safe_count;
+    int eliminated_count;
+    int unfinished_count;
+
+    // By strategy, for a game of strategy_counts
+    std::vector<StrategyResult> by_strategy{};
+};
+
+struct SimulationSummary {
+    long long game_count = 0;
+    long long safe_count = 0;
+    long long eliminated_count = 0;
+    long long unfinished_count = 0;
+
+    // Number of games indexed by how many actors were safe in it
+    std::vector<long long> safe_histogram;
+
+    std::vector<StrategyResult> by_strategy{};
+
+    void add(const GameResult& result);
+
+    void merge(const SimulationSummary& other);
+
+    void display(const SimulationConfig& config, double seconds) const;
+};
+
+class ThreadPool;
+struct Snapshot;
+
+// Play one game without any console I/O, using the calling thread's generator.
+// With a pool, the phases that can run in parallel are split over it.
+// With a start, the game picks up from it instead of beginning anew. Only the game of the seed the snapshot
+// was taken with continues its generator; any other seed forks a new game from the same position.
+// With eliminated_by_round, the actors eliminated in each round are added to it, indexed by round.
+GameResult simulate_game(const SimulationConfig& config, const std::vector<std::string_view>& names, unsigned seed,
+                         ThreadPool* pool = nullptr, const Snapshot* start = nullptr,
+                         std::vector<long long>* eliminated_by_round = nullptr);
+
+// Whether all the cards the actors start with add up to no more than an int holds, as the card counts of
+// Global and their total do; the hand-class engine would otherwise play with wrapped counts
+bool card_counts_fit(const SimulationConfig& config);
+
+// Play every game of the seed range over a thread pool
+SimulationSummary simulate(const SimulationConfig& config, const std::vector<std::string_view>& names,
+                           const Snapshot* start = nullptr);
+
+// Entry point of `animal_world --simulate ...`
+int run_simulation(int argc, char** argv);
+
+#endif //ANIMAL_WORLD_SIMULATE_H
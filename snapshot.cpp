@@ -0,0 +1,274 @@
+#include "snapshot.h"
+
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+
+using std::vector;
+using std::string;
+
+// Layout of a snapshot: this header, the names file path, the generator state as text, padding to a multiple
+// of 8 bytes, the player record if there is one, actor_count actor records, bucket_count BucketRecords and
+// finally member_count actor record indexes, the members of every bucket in turn
+struct SnapshotHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t actor_count;
+    uint32_t round;
+    uint32_t seed;
+    int32_t stone_count;
+    int32_t scissor_count;
+    int32_t paper_count;
+    uint32_t has_player;
+    uint64_t names_file_size;
+    uint32_t names_path_size;
+    uint32_t generator_size;
+    uint64_t bucket_count;
+    uint64_t member_count;
+};
+
+// One actor; name is its line in the names file, or -1 when it has none from there
+struct PackedActor {
+    int32_t id;
+    int32_t name;
+    uint16_t stone_count;
+    uint16_t scissor_count;
+    uint16_t paper_count;
+    int16_t star_count;
+};
+
+static_assert(sizeof(PackedActor) == 16, "actor records are meant to pack into 16 bytes");
+
+struct BucketRecord {
+    uint32_t key;
+    uint32_t member_count;
+};
+
+static const char snapshot_magic[4] = {'A', 'W', 'S', 'S'};
+static const uint32_t snapshot_version = 1;
+
+static size_t padded(size_t size) {
+    return (size + 7) & ~(size_t) 7;
+}
+
+static bool pack(const Actor& actor, const NamePool& names, PackedActor& packed) {
+    if (actor.stone_count < 0 || actor.stone_count > UINT16_MAX || actor.scissor_count < 0 ||
+        actor.scissor_count > UINT16_MAX || actor.paper_count < 0 || actor.paper_count > UINT16_MAX ||
+        actor.star_count < INT16_MIN || actor.star_count > INT16_MAX)
+        return false;
+
+    long long name = names.index_of(actor.name);
+    packed.id = actor.id;
+    packed.name = name >= 0 && name <= INT32_MAX ? (int32_t) name : -1;
+    packed.stone_count = (uint16_t) actor.stone_count;
+    packed.scissor_count = (uint16_t) actor.scissor_count;
+    packed.paper_count = (uint16_t) actor.paper_count;
+    packed.star_count = (int16_t) actor.star_count;
+    return true;
+}
+
+// Move offset past count records of size bytes; false when they run past end
+static bool skip_records(size_t& offset, size_t end, uint64_t count, size_t size) {
+    if (offset > end || count > (end - offset) / size) return false;
+    offset += count * size;
+    return true;
+}
+
+static Actor unpack(const PackedActor& packed, const NamePool* names) {
+    Actor actor{};
+    actor.id = packed.id;
+    // An index past the end of the names file leaves the actor nameless
+    if (names != nullptr && packed.name >= 0 && names->index_through(packed.name))
+        actor.name = (*names)[packed.name];
+    actor.stone_count = packed.stone_count;
+    actor.scissor_count = packed.scissor_count;
+    actor.paper_count = packed.paper_count;
+    actor.star_count = packed.star_count;
+    return actor;
+}
+
+static void write_padding(std::ofstream& fs, size_t size) {
+    static const char zeros[8] = {};
+    fs.write(zeros, (std::streamsize) (padded(size) - size));
+}
+
+bool save_snapshot(const string& filename, Global& global, const SnapshotMeta& meta, const NamePool& names) {
+    global.refresh();
+    auto& actors = global.actors;
+
+    std::ostringstream generator_state;
+    generator_state << meta.generator;
+    string generator = generator_state.str();
+
+    SnapshotHeader header{};
+    memcpy(header.magic, snapshot_magic, sizeof(header.magic));
+    header.version = snapshot_version;
+    header.actor_count = actors.size();
+    header.round = meta.round;
+    header.seed = meta.seed;
+    header.stone_count = global.stone_count;
+    header.scissor_count = global.scissor_count;
+    header.paper_count = global.paper_count;
+    header.has_player = meta.has_player;
+    header.names_file_size = names.file_size();
+    header.names_path_size = (uint32_t) names.path().size();
+    header.generator_size = (uint32_t) generator.size();
+    header.bucket_count = global.hand_buckets.size();
+    header.member_count = (uint64_t) global.eligible_count;
+
+    PackedActor player{};
+    if (meta.has_player && !pack(meta.player, names, player)) return false;
+
+    std::ofstream fs{filename, std::ios::binary};
+    fs.write((const char*) &header, sizeof(header));
+    fs.write(names.path().data(), header.names_path_size);
+    fs.write(generator.data(), header.generator_size);
+    write_padding(fs, sizeof(header) + header.names_path_size + header.generator_size);
+    if (meta.has_player) fs.write((const char*) &player, sizeof(player));
+
+    // Records go out in blocks, so that a large world is never packed in memory all at once
+    constexpr size_t block_size = 4096;
+    vector<PackedActor> block;
+    block.reserve(block_size);
+    auto flush = [&]() {
+        fs.write((const char*) block.data(), (std::streamsize) (block.size() * sizeof(PackedActor)));
+        block.clear();
+    };
+
+    // Buckets name their members by record, which is their position among the live actors
+    vector<uint32_t> slot_records(actors.slot_count());
+    uint32_t record = 0;
+    for (auto& actor : actors) {
+        slot_records[actors.handle(actor).slot] = record++;
+        block.emplace_back();
+        if (!pack(actor, names, block.back())) return false;
+        if (block.size() == block_size) flush();
+    }
+    flush();
+
+    for (auto& bucket : global.hand_buckets) {
+        BucketRecord bucket_record{bucket.key, (uint32_t) bucket.members.size()};
+        fs.write((const char*) &bucket_record, sizeof(bucket_record));
+    }
+    vector<uint32_t> members;
+    for (auto& bucket : global.hand_buckets) {
+        members.clear();
+        for (auto handle : bucket.members)
+            members.push_back(slot_records[handle.slot]);
+        fs.write((const char*) members.data(), (std::streamsize) (members.size() * sizeof(uint32_t)));
+    }
+    return (bool) fs;
+}
+
+bool load_snapshot(const string& filename, const NamePool& names, Snapshot& snapshot) {
+    MappedFile file(filename);
+    if (!file.is_open() || file.size() < sizeof(SnapshotHeader)) return false;
+
+    SnapshotHeader header{};
+    memcpy(&header, file.data(), sizeof(header));
+    if (memcmp(header.magic, snapshot_magic, sizeof(header.magic)) != 0 || header.version != snapshot_version)
+        return false;
+
+    // Every section is checked against what is left of the file before its size is worked out, so a corrupt
+    // count cannot overflow the offsets
+    size_t offset = sizeof(header);
+    if (!skip_records(offset, file.size(), header.names_path_size, 1) ||
+        !skip_records(offset, file.size(), header.generator_size, 1))
+        return false;
+    size_t records_begin = padded(offset);
+    if (header.actor_count > file.size() / sizeof(PackedActor)) return false;
+    uint64_t record_count = header.actor_count + (header.has_player ? 1 : 0);
+    size_t buckets_begin = records_begin;
+    if (!skip_records(buckets_begin, file.size(), record_count, sizeof(PackedActor))) return false;
+    size_t members_begin = buckets_begin;
+    if (!skip_records(members_begin, file.size(), header.bucket_count, sizeof(BucketRecord))) return false;
+    size_t members_end = members_begin;
+    if (!skip_records(members_end, file.size(), header.member_count, sizeof(uint32_t))) return false;
+    if (members_end != file.size()) return false;
+
+    auto& meta = snapshot.meta;
+    const char* strings = file.data() + sizeof(header);
+    meta.names_file.assign(strings, header.names_path_size);
+    std::istringstream generator_state{string(strings + header.names_path_size, header.generator_size)};
+    generator_state >> meta.generator;
+    if (!generator_state) return false;
+
+    meta.round = header.round;
+    meta.seed = header.seed;
+    snapshot.counts.stone_count = header.stone_count;
+    snapshot.counts.scissor_count = header.scissor_count;
+    snapshot.counts.paper_count = header.paper_count;
+
+    // A names file of another size cannot be the one the indexes point into
+    snapshot.names = names.is_open() && names.file_size() == header.names_file_size ? &names : nullptr;
+
+    PackedActor packed{};
+    meta.has_player = header.has_player != 0;
+    if (meta.has_player) {
+        memcpy(&packed, file.data() + records_begin, sizeof(packed));
+        meta.player = unpack(packed, snapshot.names);
+        records_begin += sizeof(packed);
+    }
+
+    // Bucket sizes must add up to the member count and every member must name a record, so that restoring
+    // the buckets cannot fail later
+    uint64_t members_left = header.member_count;
+    for (uint64_t i = 0; i < header.bucket_count; ++i) {
+        BucketRecord bucket_record{};
+        memcpy(&bucket_record, file.data() + buckets_begin + i * sizeof(bucket_record), sizeof(bucket_record));
+        if (bucket_record.member_count > members_left) return false;
+        members_left -= bucket_record.member_count;
+    }
+    if (members_left != 0) return false;
+    const char* member = file.data() + members_begin;
+    for (uint64_t i = 0; i < header.member_count; ++i, member += sizeof(uint32_t)) {
+        uint32_t index;
+        memcpy(&index, member, sizeof(index));
+        if (index >= header.actor_count) return false;
+    }
+
+    snapshot.actor_count = header.actor_count;
+    snapshot.bucket_count = header.bucket_count;
+    snapshot.records_begin = records_begin;
+    snapshot.buckets_begin = buckets_begin;
+    snapshot.members_begin = members_begin;
+    snapshot.file = std::move(file);
+    return true;
+}
+
+Actor Snapshot::actor(size_t index) const {
+    PackedActor packed{};
+    memcpy(&packed, file.data() + records_begin + index * sizeof(packed), sizeof(packed));
+    return unpack(packed, names);
+}
+
+ActorRegistry Snapshot::restore_actors() const {
+    ActorRegistry actors;
+    actors.reserve(actor_count);
+    for (size_t i = 0; i < actor_count; ++i)
+        actors.add(actor(i));
+    return actors;
+}
+
+vector<HandBucket> Snapshot::restore_buckets() const {
+    // Actors are added to an empty registry, so record i sits in slot i
+    vector<HandBucket> buckets(bucket_count);
+    const char* member = file.data() + members_begin;
+    for (size_t i = 0; i < bucket_count; ++i) {
+        BucketRecord bucket_record{};
+        memcpy(&bucket_record, file.data() + buckets_begin + i * sizeof(bucket_record), sizeof(bucket_record));
+
+        auto& bucket = buckets[i];
+        bucket.key = bucket_record.key;
+        bucket.members.resize(bucket_record.member_count);
+        for (auto& handle : bucket.members) {
+            uint32_t index;
+            memcpy(&index, member, sizeof(index));
+            member += sizeof(index);
+            handle = ActorHandle{index, 0};
+        }
+    }
+    return buckets;
+}
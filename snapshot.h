@@ -0,0 +1,76 @@
+#ifndef ANIMAL_WORLD_SNAPSHOT_H
+#define ANIMAL_WORLD_SNAPSHOT_H
+
+#include "game.h"
+#include "name_pool.h"
+#include "mapped_file.h"
+
+#include <string>
+#include <random>
+
+// A game as it stood at the start of a round, saved to a compact binary file and mapped back.
+//
+// Actors are stored as packed 16-byte records in registry order. Names are not stored: a record holds the
+// line of the names file the actor was named from, and the file itself is referenced by path and size.
+// The generator and the order of Global's hand buckets are saved too, since ties in the ranking are broken
+// by both, so a restored game plays on exactly as the original would have.
+
+// What a snapshot holds besides the actors and Global
+struct SnapshotMeta {
+    // The round the game resumes at
+    uint32_t round = 0;
+    // The seed the game was started with
+    unsigned seed = 0;
+
+    std::default_random_engine generator;
+
+    // The interactive player, who is not one of the actors
+    bool has_player = false;
+    Actor player{};
+
+    // The names file the snapshot was written with, filled in on load
+    std::string names_file;
+};
+
+// A saved game, served from the mapped file. Loading only checks the file and reads the header; the actor
+// records are unpacked when asked for, so a game is taken up again with
+// Global(restore_actors(), counts, restore_buckets()) and looking into a snapshot costs nothing per actor.
+class Snapshot {
+public:
+    CardCounts counts;
+    SnapshotMeta meta;
+
+    // Number of actors, not counting the player
+    [[nodiscard]] size_t size() const { return actor_count; }
+
+    // The actor of record index, unpacked from the mapping
+    [[nodiscard]] Actor actor(size_t index) const;
+
+    // Every actor in a fresh registry, record i in slot i
+    [[nodiscard]] ActorRegistry restore_actors() const;
+
+    // Global's hand buckets in their saved order, naming actors of a registry from restore_actors()
+    [[nodiscard]] std::vector<HandBucket> restore_buckets() const;
+
+private:
+    friend bool load_snapshot(const std::string& filename, const NamePool& names, Snapshot& snapshot);
+
+    MappedFile file;
+    // The pool names are taken from, or nullptr when the snapshot was written with another names file
+    const NamePool* names = nullptr;
+    size_t actor_count = 0;
+    size_t bucket_count = 0;
+    size_t records_begin = 0;
+    size_t buckets_begin = 0;
+    size_t members_begin = 0;
+};
+
+// Write the game to filename, naming names by their line in the pool. Refreshes the global first.
+// Fails when a hand or star count does not fit its packed field.
+bool save_snapshot(const std::string& filename, Global& global, const SnapshotMeta& meta, const NamePool& names);
+
+// Map a snapshot and check it through. Names are taken from the pool, which must outlive the snapshot, when
+// it is the same size as the names file the snapshot was written with; otherwise actors stay nameless.
+bool load_snapshot(const std::string& filename, const NamePool& names, Snapshot& snapshot);
+
+#endif //ANIMAL_WORLD_SNAPSHOT_H
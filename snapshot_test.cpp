@@ -0,0 +1,151 @@
+#include "snapshot.h"
+#include "compete_ranking.h"
+#include "round_arena.h"
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <cstdio>
+
+using std::cerr;
+using std::endl;
+using std::vector;
+
+// Every actor still in the game, as a flat list of id, hand and stars
+static vector<int> state_of(const ActorRegistry& actors) {
+    vector<int> state;
+    for (auto& actor : actors)
+        state.insert(state.end(), {actor.id, actor.stone_count, actor.scissor_count, actor.paper_count,
+                                   actor.star_count});
+    return state;
+}
+
+// Play rounds first_round to end_round, adding the state after each to transcript
+static void play(Global& global, int first_round, int end_round, vector<vector<int>>& transcript) {
+    RoundArena arena;
+    for (int round = first_round; round < end_round && !global.actors.empty(); ++round) {
+        RoundScope round_scope(arena);
+        auto list = compete_list(global);
+        auto_compete(global, list);
+        remove_actors(global);
+        auto candidates = negotiate_candidates(global, list);
+        list = negotiate_list(candidates);
+        auto_negotiate(global, list);
+        finish_round(global);
+        transcript.push_back(state_of(global.actors));
+    }
+}
+
+static bool same_actor(const Actor& a1, const Actor& a2) {
+    return a1.id == a2.id && a1.name == a2.name && a1.stone_count == a2.stone_count &&
+           a1.scissor_count == a2.scissor_count && a1.paper_count == a2.paper_count &&
+           a1.star_count == a2.star_count;
+}
+
+// Saving a game part way, loading it and playing on must give the registry, Global and generator the game had
+// and the rounds the game went on to play
+int main() {
+    const char* names_file = "snapshot_test_names.txt";
+    const char* snapshot_file = "snapshot_test.snap";
+    const int actor_count = 2000;
+    const int saved_round = 3;
+    const int round_count = 20;
+    {
+        std::ofstream fs{names_file};
+        for (int i = 0; i < actor_count; ++i)
+            fs << "Actor " << i << '\n';
+    }
+    NamePool names(names_file);
+
+    int failures = 0;
+    for (unsigned seed : {1u, 2u, 3u}) {
+        generator.seed(seed);
+        auto actors = init_actors(actor_count, names.first(actor_count));
+        Global global(actors);
+        global.seed = seed;
+        vector<vector<int>> transcript;
+        play(global, 0, saved_round, transcript);
+
+        SnapshotMeta meta;
+        meta.round = saved_round;
+        meta.seed = seed;
+        meta.generator = generator;
+        if (!save_snapshot(snapshot_file, global, meta, names)) {
+            cerr << "seed " << seed << ": cannot save the snapshot" << endl;
+            ++failures;
+            continue;
+        }
+
+        Snapshot snapshot;
+        if (!load_snapshot(snapshot_file, names, snapshot)) {
+            cerr << "seed " << seed << ": cannot load the snapshot" << endl;
+            ++failures;
+            continue;
+        }
+        auto restored_actors = snapshot.restore_actors();
+        auto restored_buckets = snapshot.restore_buckets();
+
+        // The registry, record by record in registry order
+        bool same = snapshot.size() == actors.size() && restored_actors.size() == actors.size();
+        auto restored_actor = restored_actors.begin();
+        size_t record = 0;
+        for (auto& actor : actors) {
+            if (!same) break;
+            same = same_actor(actor, *restored_actor) && same_actor(actor, snapshot.actor(record));
+            ++restored_actor;
+            ++record;
+        }
+        if (!same) {
+            cerr << "seed " << seed << ": the actors differ" << endl;
+            ++failures;
+        }
+
+        // Global's counts and buckets, in bucket order and member order
+        same = snapshot.counts.stone_count == global.stone_count &&
+               snapshot.counts.scissor_count == global.scissor_count &&
+               snapshot.counts.paper_count == global.paper_count &&
+               restored_buckets.size() == global.hand_buckets.size();
+        for (size_t i = 0; same && i < restored_buckets.size(); ++i) {
+            auto& bucket = global.hand_buckets[i];
+            auto& restored_bucket = restored_buckets[i];
+            same = bucket.key == restored_bucket.key && bucket.members.size() == restored_bucket.members.size();
+            for (size_t j = 0; same && j < bucket.members.size(); ++j)
+                same = actors[bucket.members[j]].id == restored_actors[restored_bucket.members[j]].id;
+        }
+        if (!same) {
+            cerr << "seed " << seed << ": Global's counts or buckets differ" << endl;
+            ++failures;
+        }
+
+        if (snapshot.meta.round != (uint32_t) saved_round || snapshot.meta.seed != seed ||
+            !(snapshot.meta.generator == generator)) {
+            cerr << "seed " << seed << ": the round, seed or generator differ" << endl;
+            ++failures;
+        }
+
+        // Both games play on from the same position
+        vector<vector<int>> original_rest;
+        play(global, saved_round, round_count, original_rest);
+
+        generator = snapshot.meta.generator;
+        Global restored(restored_actors, snapshot.counts, restored_buckets);
+        restored.round = (int) snapshot.meta.round;
+        restored.seed = snapshot.meta.seed;
+        vector<vector<int>> restored_rest;
+        play(restored, saved_round, round_count, restored_rest);
+
+        if (restored_rest != original_rest) {
+            size_t round = 0;
+            while (round < restored_rest.size() && round < original_rest.size() &&
+                   restored_rest[round] == original_rest[round])
+                ++round;
+            cerr << "seed " << seed << ": the restored game departs from the original in round "
+                 << saved_round + round << endl;
+            ++failures;
+        }
+    }
+
+    std::remove(snapshot_file);
+    std::remove(names_file);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,164 @@
+#include "speculation.h"
+#include "compete_ranking.h"
+#include "round_arena.h"
+#include "event_trace.h"
+
+#include <algorithm>
+#include <utility>
+
+using std::vector;
+
+PlayerMatch play_player_match(Global& global, Actor& player, Actor& other, Card player_card) {
+    PROFILE_PHASE(Phase::COMPETITION);
+    Card other_card = npc_compete(global, global, other, player);
+
+    consume_card(global, player, player_card);
+    consume_card(global, other, other_card);
+
+    int result = single_compete(player_card, other_card);
+    trace_event(EventType::MATCH_PLAYED, player.id, other.id, (uint8_t) player_card, (uint8_t) other_card,
+                (int8_t) result);
+    if (result == 1) trace_event(EventType::STAR_TRANSFERRED, player.id, other.id, no_card, no_card, 1);
+    else if (result == -1) trace_event(EventType::STAR_TRANSFERRED, other.id, player.id, no_card, no_card, 1);
+
+    if (result == 1) {
+        player.star_count++;
+        other.star_count--;
+    } else if (result == -1) {
+        player.star_count--;
+        other.star_count++;
+    }
+    return {true, other.name, player_card, other_card, result};
+}
+
+void render_player_match(Frame& frame, const PlayerMatch& match) {
+    if (!match.played) {
+        frame << "No one wants to compete with you this round\n";
+        return;
+    }
+
+    frame << "You uses " << verbose(match.player_card) << '\n';
+    frame << match.other_name << " uses " << verbose(match.other_card) << '\n';
+    if (match.result == 1) frame << "You win\n";
+    else if (match.result == -1) frame << "You lose\n";
+    else frame << "It's a tie\n";
+}
+
+void play_round_ahead(Global& global, Actor& player, const PlayerDecision& decision, size_t page_size,
+                      RoundOutcome& outcome) {
+    auto& actors = global.actors;
+    auto& list = outcome.list;
+    list = compete_list(global);
+
+    if (decision.compete && !list.empty()) {
+        list.pop_back();
+        auto competitor = list.back();
+        list.pop_back();
+        outcome.match = play_player_match(global, player, actors[competitor], decision.card);
+        global.touch(competitor);
+    }
+
+    // The game is over for the player either way, and nothing more is played
+    outcome.player_check = check_actor(global, player);
+    if (outcome.player_check != CheckResult::CONTINUE) return;
+
+    auto_compete(global, list);
+
+    {
+        PROFILE_PHASE(Phase::DISPLAY);
+        outcome.results << "Other competition results:\n";
+        // Only actors that changed can be safe or eliminated; storage order keeps the listing in actor order
+        global.refresh();
+        vector<const Actor*> checked;
+        for (auto* filed : {&global.safe_actors, &global.eliminated_actors})
+            for (auto handle : *filed)
+                checked.push_back(&actors[handle]);
+        size_t shown = page_size == 0 ? checked.size() : std::min(checked.size(), page_size);
+        std::partial_sort(checked.begin(), checked.begin() + (long) shown, checked.end());
+        for (size_t i = 0; i < shown; ++i)
+            render_check_actor(outcome.results, global, *checked[i]);
+        if (shown < checked.size())
+            outcome.results << "(" << checked.size() - shown << " more are safe or eliminated)\n";
+        outcome.results << '\n';
+    }
+
+    remove_actors(global);
+
+    outcome.candidates = negotiate_candidates(global, list);
+
+    // A player who competed has no part in the negotiation
+    if (decision.compete) {
+        list = negotiate_list(outcome.candidates);
+        auto_negotiate(global, list);
+        finish_round(global);
+        outcome.finished = true;
+    }
+}
+
+RoundSpeculation::RoundSpeculation(const Global& global, const Actor& player, size_t page_size)
+        : page_size{page_size} {
+    vector<PlayerDecision> decisions{{false, Card::STONE}};
+    if (player.can_compete())
+        for (int i = 0; i < 3; ++i)
+            if (player.card_count((Card) i) > 0) decisions.push_back({true, (Card) i});
+
+    const GameEngine engine = generator;
+    Profiler* profiler = current_profiler;
+    int round = profiler != nullptr ? profiler->current_round() : 0;
+
+    for (auto& decision : decisions) {
+        auto branch = std::make_unique<Branch>();
+        branch->decision = decision;
+        branch->copied_future = branch->copied.get_future();
+        branch->thread = std::thread([&global, &player, engine, profiler, round, page_size, branch = branch.get()] {
+            branch->actors = global.actors;
+            branch->global.emplace(branch->actors, global);
+            branch->player = player;
+            branch->copied.set_value();
+
+            generator = engine;
+            branch->profiler.set_round(round);
+            ProfilerScope profiler_scope(profiler != nullptr ? &branch->profiler : nullptr);
+            RoundArena arena;
+            RoundScope round_scope(arena);
+            play_round_ahead(*branch->global, branch->player, branch->decision, page_size, branch->outcome);
+            branch->engine = generator;
+        });
+        branches.push_back(std::move(branch));
+    }
+}
+
+RoundSpeculation::~RoundSpeculation() {
+    for (auto& branch : branches)
+        if (branch->thread.joinable()) branch->thread.join();
+}
+
+void RoundSpeculation::wait_copied() {
+    for (auto& branch : branches)
+        branch->copied_future.wait();
+}
+
+void RoundSpeculation::commit(const PlayerDecision& decision, Global& global, Actor& player,
+                              RoundOutcome& outcome) {
+    // Branches still copying the game would see it change under them
+    wait_copied();
+
+    for (auto& branch : branches) {
+        if (branch->decision.compete != decision.compete) continue;
+        if (decision.compete && branch->decision.card != decision.card) continue;
+
+        branch->thread.join();
+        global.actors = std::move(branch->actors);
+        global.take(std::move(*branch->global));
+        player = branch->player;
+        generator = branch->engine;
+        if (current_profiler != nullptr) current_profiler->merge(branch->profiler);
+
+        // Copied rather than moved, so that the lists move to the memory of the caller's round
+        outcome = branch->outcome;
+        return;
+    }
+
+    // Not a decision the player could make; play it here
+    play_round_ahead(global, player, decision, page_size, outcome);
+}
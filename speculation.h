@@ -0,0 +1,102 @@
+#ifndef ANIMAL_WORLD_SPECULATION_H
+#define ANIMAL_WORLD_SPECULATION_H
+
+#include "game.h"
+#include "render.h"
+#include "profiler.h"
+
+#include <vector>
+#include <memory>
+#include <thread>
+#include <future>
+#include <optional>
+#include <memory_resource>
+#include <string_view>
+#include <cstddef>
+
+// The player's answer to the first questions of a round
+struct PlayerDecision {
+    bool compete = false;
+    // Only meaningful when competing
+    Card card = Card::STONE;
+};
+
+// The player's match, played but not shown yet
+struct PlayerMatch {
+    bool played = false;
+    std::string_view other_name;
+    Card player_card = Card::STONE;
+    Card other_card = Card::STONE;
+    int result = 0;
+};
+
+PlayerMatch play_player_match(Global& global, Actor& player, Actor& other, Card player_card);
+
+// What the player is told about the match, or that nobody took them on
+void render_player_match(Frame& frame, const PlayerMatch& match);
+
+// What the NPC side of a round leaves for the player to see and do
+struct RoundOutcome {
+    explicit RoundOutcome(std::pmr::memory_resource* resource) : list(resource), candidates(resource) {}
+
+    HandleList list;
+    HandleList candidates;
+
+    PlayerMatch match;
+    CheckResult player_check = CheckResult::CONTINUE;
+
+    // Who turned out safe or eliminated in the competition
+    Frame results;
+
+    // Whether the negotiation has been played and the round finished too, which happens when the player
+    // competes and so has no part in the negotiation
+    bool finished = false;
+};
+
+// Play the round from the player's decision on, in the order the game always has, as far as it can go
+// without asking the player anything more
+void play_round_ahead(Global& global, Actor& player, const PlayerDecision& decision, size_t page_size,
+                      RoundOutcome& outcome);
+
+// Plays play_round_ahead for every decision open to the player while they are still making it, each on a
+// copy of the game and a thread of its own. Each copy starts from the generator of the calling thread, so
+// the branch the player takes is exactly what playing the round after their answer would have given.
+// Events recorded by branches would not be known to belong to the game, so tracing must be off.
+class RoundSpeculation {
+public:
+    RoundSpeculation(const Global& global, const Actor& player, size_t page_size);
+
+    ~RoundSpeculation();
+
+    RoundSpeculation(const RoundSpeculation&) = delete;
+
+    RoundSpeculation& operator=(const RoundSpeculation&) = delete;
+
+    // Wait until every branch has its copy, after which the game may be changed again
+    void wait_copied();
+
+    // Wait for the branch of the decision and move its game into global, player and the generator of the
+    // calling thread
+    void commit(const PlayerDecision& decision, Global& global, Actor& player, RoundOutcome& outcome);
+
+private:
+    struct Branch {
+        PlayerDecision decision;
+
+        ActorRegistry actors;
+        std::optional<Global> global;
+        Actor player{};
+        GameEngine engine;
+        Profiler profiler;
+        RoundOutcome outcome{std::pmr::new_delete_resource()};
+
+        std::promise<void> copied;
+        std::future<void> copied_future;
+        std::thread thread;
+    };
+
+    size_t page_size;
+    std::vector<std::unique_ptr<Branch>> branches;
+};
+
+#endif //ANIMAL_WORLD_SPECULATION_H
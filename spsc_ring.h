@@ -0,0 +1,69 @@
+#ifndef ANIMAL_WORLD_SPSC_RING_H
+#define ANIMAL_WORLD_SPSC_RING_H
+
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <cstddef>
+
+// A bounded queue between exactly one producer thread and one consumer thread, without locks.
+// Each side only writes its own index; the other side's index is cached and reloaded only when
+// the cached value says the ring is full or empty, so the indexes rarely change cache lines.
+template<typename T>
+class SpscRing {
+public:
+    // capacity is rounded up to a power of two
+    explicit SpscRing(size_t capacity) : slots(round_up(capacity)), mask(slots.size() - 1) {}
+
+    SpscRing(const SpscRing&) = delete;
+
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // Producer side; false when the ring is full
+    bool try_push(const T& value) {
+        size_t tail = producer.index.load(std::memory_order_relaxed);
+        if (tail - producer.cached_other == slots.size()) {
+            producer.cached_other = consumer.index.load(std::memory_order_acquire);
+            if (tail - producer.cached_other == slots.size()) return false;
+        }
+        slots[tail & mask] = value;
+        producer.index.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side; moves up to max_count values to out and returns how many
+    size_t pop(T* out, size_t max_count) {
+        size_t head = consumer.index.load(std::memory_order_relaxed);
+        if (consumer.cached_other == head) {
+            consumer.cached_other = producer.index.load(std::memory_order_acquire);
+            if (consumer.cached_other == head) return 0;
+        }
+
+        size_t count = std::min(max_count, consumer.cached_other - head);
+        for (size_t i = 0; i < count; ++i)
+            out[i] = slots[(head + i) & mask];
+        consumer.index.store(head + count, std::memory_order_release);
+        return count;
+    }
+
+private:
+    static size_t round_up(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) size *= 2;
+        return size;
+    }
+
+    // One side's index and its last look at the other side's, on a cache line of their own
+    struct alignas(64) Side {
+        std::atomic<size_t> index{0};
+        size_t cached_other = 0;
+    };
+
+    std::vector<T> slots;
+    size_t mask;
+
+    Side producer;
+    Side consumer;
+};
+
+#endif //ANIMAL_WORLD_SPSC_RING_H
@@ -0,0 +1,41 @@
+#include "strategy.h"
+#include "lookahead.h"
+
+#include <random>
+
+const std::array<std::string_view, Tournament::group_count> strategy_names = {"heuristic", "uniform", "greedy",
+                                                                               "cautious"};
+
+bool DefaultStrategy::will_compete(const Global& global, const Actor& actor) const {
+    auto* lookahead = global.lookahead;
+    return lookahead == nullptr || !lookahead->controls(actor) || lookahead->will_compete(global, actor);
+}
+
+Card UniformStrategy::choose_card(const Global&, const CardCounts&, const Actor& actor, const Actor&) const {
+    Card held[3];
+    int held_count = 0;
+    for (int i = 0; i < 3; ++i)
+        if (actor.card_count((Card) i) > 0) held[held_count++] = (Card) i;
+
+    auto dist = std::uniform_int_distribution<int>(0, held_count - 1);
+    return held[dist(generator)];
+}
+
+Card GreedyStrategy::choose_card(const Global&, const CardCounts& counts, const Actor& actor, const Actor&) const {
+    auto prob = competitor_prob(counts, actor);
+
+    // Ties go to the first card held in the heuristic's order
+    Card best = Card::STONE;
+    float best_score = -2;
+    for (Card card : {Card::PAPER, Card::STONE, Card::SCISSOR}) {
+        if (actor.card_count(card) <= 0) continue;
+        // Each card beats the next one, cyclically, and loses to the one before
+        int index = (int) card;
+        float score = prob.values[(index + 1) % 3] - prob.values[(index + 2) % 3];
+        if (score > best_score) {
+            best = card;
+            best_score = score;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,207 @@
+#ifndef ANIMAL_WORLD_STRATEGY_H
+#define ANIMAL_WORLD_STRATEGY_H
+
+#include "game.h"
+
+#include <array>
+#include <tuple>
+#include <vector>
+#include <string_view>
+#include <utility>
+#include <cstddef>
+
+class ThreadPool;
+
+// A strategy makes the decisions of the NPCs that play by it. It is a type with these members, and the round
+// phases are templates over it, so that each decision is a direct call the compiler can inline into the loop
+// that makes it:
+//
+//   // The card actor plays against opponent, counts being the cards still in play
+//   Card choose_card(const Global& global, const CardCounts& counts, const Actor& actor, const Actor& opponent) const;
+//   // Whether anyone may turn down a place in the compete list this round; false skips asking
+//   bool may_decline(const Global& global) const;
+//   // Whether to keep a place drawn in the compete list
+//   bool will_compete(const Global& global, const Actor& actor) const;
+//   // Whether to take card from, or give it to, the other side of a negotiation
+//   bool will_receive(const Global& global, const Actor& actor, Card card) const;
+//   bool will_give(const Global& global, const Actor& actor, Card card) const;
+
+// The game's own NPCs: the heuristic, and the lookahead for the actors it controls
+struct DefaultStrategy {
+    Card choose_card(const Global& global, const CardCounts& counts, const Actor& actor,
+                     const Actor& opponent) const {
+        return npc_compete(global, counts, actor, opponent);
+    }
+
+    bool may_decline(const Global& global) const { return global.lookahead != nullptr; }
+
+    bool will_compete(const Global& global, const Actor& actor) const;
+
+    bool will_receive(const Global& global, const Actor& actor, Card card) const {
+        return can_receive_card(global, actor, card);
+    }
+
+    bool will_give(const Global& global, const Actor& actor, Card card) const {
+        return can_give_card(global, actor, card);
+    }
+};
+
+// Plays any kind of card it holds with the same chance, and trades as the heuristic does
+struct UniformStrategy {
+    Card choose_card(const Global& global, const CardCounts& counts, const Actor& actor,
+                     const Actor& opponent) const;
+
+    bool may_decline(const Global&) const { return false; }
+
+    bool will_compete(const Global&, const Actor&) const { return true; }
+
+    bool will_receive(const Global& global, const Actor& actor, Card card) const {
+        return can_receive_card(global, actor, card);
+    }
+
+    bool will_give(const Global& global, const Actor& actor, Card card) const {
+        return can_give_card(global, actor, card);
+    }
+};
+
+// Plays the card it holds with the best odds of winning less the odds of losing, against the cards everyone
+// else holds, instead of drawing one; trades as the heuristic does
+struct GreedyStrategy {
+    Card choose_card(const Global& global, const CardCounts& counts, const Actor& actor,
+                     const Actor& opponent) const;
+
+    bool may_decline(const Global&) const { return false; }
+
+    bool will_compete(const Global&, const Actor&) const { return true; }
+
+    bool will_receive(const Global& global, const Actor& actor, Card card) const {
+        return can_receive_card(global, actor, card);
+    }
+
+    bool will_give(const Global& global, const Actor& actor, Card card) const {
+        return can_give_card(global, actor, card);
+    }
+};
+
+// The heuristic, except that it stops competing once it has the stars to be safe, since a match can then
+// only cost it, and waits to trade its cards away instead
+struct CautiousStrategy {
+    Card choose_card(const Global&, const CardCounts& counts, const Actor& actor, const Actor&) const {
+        return actor_compete(counts, actor);
+    }
+
+    bool may_decline(const Global&) const { return true; }
+
+    bool will_compete(const Global& global, const Actor& actor) const {
+        return actor.star_count < global.rules.safe_star_count;
+    }
+
+    bool will_receive(const Global& global, const Actor& actor, Card card) const {
+        return can_receive_card(global, actor, card);
+    }
+
+    bool will_give(const Global& global, const Actor& actor, Card card) const {
+        return can_give_card(global, actor, card);
+    }
+};
+
+// A population of several strategies, grouped by actor id: the first counts[0] ids play by the first strategy,
+// the next counts[1] by the second, and so on, with any id past the groups in the last one. Finding an actor's
+// group takes a comparison with each bound, and the group's strategy is picked by a switch the compiler
+// unrolls, so a mixed population is played without calls through pointers.
+template<typename... Strategies>
+class StrategyMix {
+public:
+    static constexpr size_t group_count = sizeof...(Strategies);
+
+    explicit StrategyMix(const std::array<int, group_count>& counts, Strategies... strategies)
+            : strategies{strategies...} {
+        int end = 0;
+        for (size_t group = 0; group < group_count; ++group) {
+            end += counts[group];
+            ends[group] = end;
+            present[group] = counts[group] > 0;
+        }
+    }
+
+    explicit StrategyMix(const std::array<int, group_count>& counts) : StrategyMix(counts, Strategies{}...) {}
+
+    [[nodiscard]] size_t group_of(const Actor& actor) const {
+        for (size_t group = 0; group + 1 < group_count; ++group)
+            if (actor.id <= ends[group]) return group;
+        return group_count - 1;
+    }
+
+    Card choose_card(const Global& global, const CardCounts& counts, const Actor& actor,
+                     const Actor& opponent) const {
+        return decide(group_of(actor), [&](auto& strategy) {
+            return strategy.choose_card(global, counts, actor, opponent);
+        });
+    }
+
+    bool may_decline(const Global& global) const {
+        bool result = false;
+        for (size_t group = 0; group < group_count; ++group)
+            if (present[group])
+                result = result || decide(group, [&](auto& strategy) { return strategy.may_decline(global); });
+        return result;
+    }
+
+    bool will_compete(const Global& global, const Actor& actor) const {
+        return decide(group_of(actor), [&](auto& strategy) { return strategy.will_compete(global, actor); });
+    }
+
+    bool will_receive(const Global& global, const Actor& actor, Card card) const {
+        return decide(group_of(actor), [&](auto& strategy) { return strategy.will_receive(global, actor, card); });
+    }
+
+    bool will_give(const Global& global, const Actor& actor, Card card) const {
+        return decide(group_of(actor), [&](auto& strategy) { return strategy.will_give(global, actor, card); });
+    }
+
+private:
+    // The decision of group's strategy
+    template<size_t I = 0, typename Decision>
+    auto decide(size_t group, Decision&& decision) const {
+        if constexpr (I + 1 == group_count) return decision(std::get<I>(strategies));
+        else {
+            if (group == I) return decision(std::get<I>(strategies));
+            return decide<I + 1>(group, std::forward<Decision>(decision));
+        }
+    }
+
+    std::tuple<Strategies...> strategies;
+    std::array<int, group_count> ends{};
+    std::array<bool, group_count> present{};
+};
+
+// Every strategy above, in the order tournaments name them; see strategy_names
+using Tournament = StrategyMix<DefaultStrategy, UniformStrategy, GreedyStrategy, CautiousStrategy>;
+
+// heuristic, uniform, greedy and cautious
+extern const std::array<std::string_view, Tournament::group_count> strategy_names;
+
+// The round phases of game.h and compete_ranking.h with the decisions left to a strategy; those take
+// DefaultStrategy. The library is built with DefaultStrategy and Tournament; include game_phases.h to play by
+// any other.
+
+template<typename Strategy>
+void choose_compete_cards(const Global& global, const HandleList& list, std::pmr::vector<uint8_t>& cards1,
+                          std::pmr::vector<uint8_t>& cards2, const Strategy& strategy);
+
+template<typename Strategy>
+void auto_compete(Global& global, const HandleList& list, const Strategy& strategy);
+
+template<typename Strategy>
+HandleList compete_list(Global& global, const Strategy& strategy);
+
+template<typename Strategy>
+bool negotiate(const Global& global, Actor& a1, Actor& a2, const Strategy& strategy);
+
+template<typename Strategy>
+void auto_negotiate(Global& global, const HandleList& list, const Strategy& strategy);
+
+template<typename Strategy>
+void auto_negotiate_parallel(Global& global, const HandleList& list, ThreadPool& pool, const Strategy& strategy);
+
+#endif //ANIMAL_WORLD_STRATEGY_H
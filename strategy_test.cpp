@@ -0,0 +1,112 @@
+#include "game_phases.h"
+
+#include <iostream>
+#include <vector>
+#include <type_traits>
+
+using std::cerr;
+using std::endl;
+using std::vector;
+
+// The game's own NPCs under a type the library was not built with
+struct CopiedStrategy : DefaultStrategy {};
+
+// Always plays the first kind of card it holds, never turns a place down and never trades
+struct StubbornStrategy {
+    Card choose_card(const Global&, const CardCounts&, const Actor& actor, const Actor&) const {
+        if (actor.stone_count > 0) return Card::STONE;
+        if (actor.scissor_count > 0) return Card::SCISSOR;
+        return Card::PAPER;
+    }
+
+    bool may_decline(const Global&) const { return false; }
+
+    bool will_compete(const Global&, const Actor&) const { return true; }
+
+    bool will_receive(const Global&, const Actor&, Card) const { return false; }
+
+    bool will_give(const Global&, const Actor&, Card) const { return false; }
+};
+
+// Every actor still in the game, as a flat list of id, hand and stars
+static vector<int> state_of(const ActorRegistry& actors) {
+    vector<int> state;
+    for (auto& actor : actors)
+        state.insert(state.end(), {actor.id, actor.stone_count, actor.scissor_count, actor.paper_count,
+                                   actor.star_count});
+    return state;
+}
+
+// The cards the actors still in the game hold
+static long long held_cards(const ActorRegistry& actors) {
+    long long count = 0;
+    for (auto& actor : actors)
+        count += actor.total_count();
+    return count;
+}
+
+// The state after each round of the game of seed played by strategy; failures counts the rounds where the
+// matches did not use up one card per competitor, or where a strategy that never trades traded
+template<typename Strategy>
+static vector<vector<int>> play(const Strategy& strategy, unsigned seed, ThreadPool* pool, int& failures) {
+    generator.seed(seed);
+    auto actors = init_actors(1000, {});
+    Global global(actors);
+    global.seed = seed;
+    RoundArena arena;
+
+    vector<vector<int>> transcript;
+    for (int round = 0; round < 20 && !actors.empty(); ++round) {
+        RoundScope round_scope(arena);
+        auto list = compete_list(global, strategy);
+        long long counted = global.total_count();
+        long long held = held_cards(actors);
+        auto_compete(global, list, strategy);
+        if (counted - global.total_count() != (long long) list.size() ||
+            held - held_cards(actors) != (long long) list.size()) {
+            cerr << "seed " << seed << ": the matches of round " << round << " did not use up one card each" << endl;
+            ++failures;
+        }
+        remove_actors(global);
+        auto candidates = negotiate_candidates(global, list);
+        list = negotiate_list(candidates);
+
+        auto before = state_of(actors);
+        if (pool != nullptr) auto_negotiate_parallel(global, list, *pool, strategy);
+        else auto_negotiate(global, list, strategy);
+        if (std::is_same_v<Strategy, StubbornStrategy> && state_of(actors) != before) {
+            cerr << "seed " << seed << ": a strategy that never trades traded in round " << round << endl;
+            ++failures;
+        }
+
+        finish_round(global);
+        transcript.push_back(state_of(actors));
+    }
+    return transcript;
+}
+
+// A strategy defined outside the library plays through the templated phases of game_phases.h: a copy of the
+// game's own plays exactly its games, and one of its own keeps the game consistent
+int main() {
+    int failures = 0;
+    ThreadPool pool(4);
+    for (unsigned seed : {1u, 2u, 3u}) {
+        auto reference = play(DefaultStrategy{}, seed, nullptr, failures);
+        if (play(CopiedStrategy{}, seed, nullptr, failures) != reference ||
+            play(CopiedStrategy{}, seed, &pool, failures) != reference) {
+            cerr << "seed " << seed << ": a copy of DefaultStrategy plays another game" << endl;
+            ++failures;
+        }
+
+        auto stubborn = play(StubbornStrategy{}, seed, nullptr, failures);
+        if (play(StubbornStrategy{}, seed, &pool, failures) != stubborn) {
+            cerr << "seed " << seed << ": StubbornStrategy plays another game on the pool" << endl;
+            ++failures;
+        }
+        if (stubborn == reference) {
+            cerr << "seed " << seed << ": StubbornStrategy plays the game of DefaultStrategy" << endl;
+            ++failures;
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
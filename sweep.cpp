@@ -0,0 +1,375 @@
+#include "sweep.h"
+#include "thread_pool.h"
+#include "hand_class.h"
+#include "name_pool.h"
+
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+
+using std::cout;
+using std::cerr;
+using std::endl;
+using std::vector;
+using std::string;
+
+// Starting hands must fit the byte-wide columns of ActorStore with room for the cards won in trades. Hands
+// that outgrow them anyway still play, on the scalar path of compete_top.
+static constexpr int max_start_cards = 192;
+
+QuantileSketch::QuantileSketch(double relative_error)
+        : gamma{(1 + relative_error) / (1 - relative_error)}, log_gamma{std::log(gamma)} {}
+
+void QuantileSketch::add(double value) {
+    ++total;
+    if (value <= 0) {
+        ++zero_count;
+        return;
+    }
+    ++buckets[(int) std::ceil(std::log(value) / log_gamma)];
+}
+
+void QuantileSketch::merge(const QuantileSketch& other) {
+    total += other.total;
+    zero_count += other.zero_count;
+    for (auto& [index, count] : other.buckets)
+        buckets[index] += count;
+}
+
+double QuantileSketch::quantile(double q) const {
+    if (total == 0) return 0;
+
+    auto rank = (long long) (std::clamp(q, 0.0, 1.0) * (double) (total - 1));
+    if (rank < zero_count) return 0;
+    rank -= zero_count;
+    for (auto& [index, count] : buckets) {
+        if (rank < count) {
+            // The middle of the bucket by relative error, so that any value in it is within the accuracy
+            return 2 * std::pow(gamma, index) / (gamma + 1);
+        }
+        rank -= count;
+    }
+    return 2 * std::pow(gamma, buckets.rbegin()->first) / (gamma + 1);
+}
+
+void SweepAggregate::add(const GameResult& result, int actor_count) {
+    ++game_count;
+    actor_total += actor_count;
+    safe_count += result.safe_count;
+    eliminated_count += result.eliminated_count;
+    unfinished_count += result.unfinished_count;
+
+    double survival = actor_count > 0 ? (double) result.safe_count / actor_count : 0;
+    ++survival_histogram[std::min(survival_bins - 1, (int) (survival * survival_bins))];
+    survival_quantiles.add(survival);
+}
+
+void SweepAggregate::merge(const SweepAggregate& other) {
+    game_count += other.game_count;
+    actor_total += other.actor_total;
+    safe_count += other.safe_count;
+    eliminated_count += other.eliminated_count;
+    unfinished_count += other.unfinished_count;
+
+    for (int i = 0; i < survival_bins; ++i)
+        survival_histogram[i] += other.survival_histogram[i];
+    survival_quantiles.merge(other.survival_quantiles);
+
+    if (eliminated_by_round.size() < other.eliminated_by_round.size())
+        eliminated_by_round.resize(other.eliminated_by_round.size());
+    for (size_t i = 0; i < other.eliminated_by_round.size(); ++i)
+        eliminated_by_round[i] += other.eliminated_by_round[i];
+}
+
+bool set_parameter(SimulationConfig& config, std::string_view name, int value) {
+    auto& rules = config.rules;
+    bool card_count = value >= 0 && value <= max_start_cards;
+
+    if (name == "stones" && card_count) rules.stone_count = value;
+    else if (name == "scissors" && card_count) rules.scissor_count = value;
+    else if (name == "papers" && card_count) rules.paper_count = value;
+    else if (name == "cards" && card_count) rules.stone_count = rules.scissor_count = rules.paper_count = value;
+    else if (name == "stars" && value >= 0) rules.star_count = value;
+    else if (name == "safe-stars") rules.safe_star_count = value;
+    else if (name == "eliminated-stars") rules.eliminated_star_count = value;
+    else if (name == "actors" && value > 0) config.actor_count = value;
+    else if (name == "rounds" && value >= 0) config.round_count = value;
+    else return false;
+    return true;
+}
+
+vector<SimulationConfig> sweep_configurations(const SweepConfig& sweep) {
+    vector<SimulationConfig> configs;
+    auto& parameters = sweep.parameters;
+
+    if (sweep.random_count > 0) {
+        std::default_random_engine engine(sweep.search_seed);
+        for (size_t i = 0; i < sweep.random_count; ++i) {
+            auto config = sweep.base;
+            for (auto& parameter : parameters) {
+                std::uniform_int_distribution<size_t> dist(0, parameter.values.size() - 1);
+                set_parameter(config, parameter.name, parameter.values[dist(engine)]);
+            }
+            configs.push_back(config);
+        }
+        return configs;
+    }
+
+    // Counts through the grid like an odometer, the last parameter turning fastest
+    vector<size_t> choice(parameters.size(), 0);
+    while (true) {
+        auto config = sweep.base;
+        for (size_t i = 0; i < parameters.size(); ++i)
+            set_parameter(config, parameters[i].name, parameters[i].values[choice[i]]);
+        configs.push_back(config);
+
+        size_t i = parameters.size();
+        while (i > 0 && ++choice[i - 1] == parameters[i - 1].values.size())
+            choice[--i] = 0;
+        if (i == 0) break;
+    }
+    return configs;
+}
+
+vector<SweepAggregate> sweep(const SweepConfig& sweep, const vector<SimulationConfig>& configs,
+                             const vector<std::string_view>& names) {
+    auto& base = sweep.base;
+    size_t game_count = base.seed_end > base.seed_begin ? base.seed_end - base.seed_begin : 0;
+    size_t block_size = std::max<size_t>(sweep.block_size, 1);
+    size_t blocks_per_config = (game_count + block_size - 1) / block_size;
+
+    vector<SweepAggregate> aggregates(configs.size());
+    auto config_mutexes = std::make_unique<std::mutex[]>(configs.size());
+
+    ThreadPool pool(base.thread_count);
+
+    // The configuration each worker is playing, and what its games so far add up to. Stealing keeps a worker on
+    // one configuration for many units in a row, so this is merged only when it moves on.
+    struct Pending {
+        size_t config = SIZE_MAX;
+        SweepAggregate aggregate;
+    };
+    vector<Pending> pending(pool.size());
+    auto flush = [&](Pending& worker_pending) {
+        if (worker_pending.config == SIZE_MAX) return;
+        {
+            std::lock_guard<std::mutex> lock(config_mutexes[worker_pending.config]);
+            aggregates[worker_pending.config].merge(worker_pending.aggregate);
+        }
+        worker_pending.config = SIZE_MAX;
+        worker_pending.aggregate = SweepAggregate{};
+    };
+
+    pool.parallel_for_stealing(configs.size() * blocks_per_config, [&](size_t unit, int worker) {
+        size_t config_index = unit / blocks_per_config;
+        auto& config = configs[config_index];
+        auto& worker_pending = pending[worker];
+        if (worker_pending.config != config_index) {
+            flush(worker_pending);
+            worker_pending.config = config_index;
+        }
+
+        auto& aggregate = worker_pending.aggregate;
+        size_t first = unit % blocks_per_config * block_size;
+        size_t last = std::min(first + block_size, game_count);
+        for (size_t index = first; index < last; ++index) {
+            unsigned seed = base.seed_begin + (unsigned) index;
+            auto result = config.engine == Engine::HAND_CLASS
+                          ? simulate_hand_class_game(config, seed, &aggregate.eliminated_by_round)
+                          : simulate_game(config, names, seed, nullptr, nullptr, &aggregate.eliminated_by_round);
+            aggregate.add(result, config.actor_count);
+        }
+    });
+
+    for (auto& worker_pending : pending)
+        flush(worker_pending);
+    return aggregates;
+}
+
+// Values separated by spaces, to keep a list in one CSV field
+template<typename Values>
+static void write_list(std::ostream& os, const Values& values) {
+    for (size_t i = 0; i < values.size(); ++i)
+        os << (i > 0 ? " " : "") << values[i];
+}
+
+void write_sweep_csv(std::ostream& os, const vector<SimulationConfig>& configs,
+                     const vector<SweepAggregate>& aggregates) {
+    os << "stones,scissors,papers,stars,safe_stars,eliminated_stars,actors,rounds,games,"
+       << "safe_rate,eliminated_rate,unfinished_rate,survival_p10,survival_p50,survival_p90,"
+       << "survival_histogram,eliminated_by_round\n";
+
+    for (size_t i = 0; i < configs.size(); ++i) {
+        auto& config = configs[i];
+        auto& rules = config.rules;
+        auto& aggregate = aggregates[i];
+        double actor_total = aggregate.actor_total > 0 ? (double) aggregate.actor_total : 1;
+
+        os << rules.stone_count << ',' << rules.scissor_count << ',' << rules.paper_count << ','
+           << rules.star_count << ',' << rules.safe_star_count << ',' << rules.eliminated_star_count << ','
+           << config.actor_count << ',' << config.round_count << ',' << aggregate.game_count << ','
+           << (double) aggregate.safe_count / actor_total << ','
+           << (double) aggregate.eliminated_count / actor_total << ','
+           << (double) aggregate.unfinished_count / actor_total << ','
+           << aggregate.survival_quantiles.quantile(0.1) << ','
+           << aggregate.survival_quantiles.quantile(0.5) << ','
+           << aggregate.survival_quantiles.quantile(0.9) << ',';
+        write_list(os, aggregate.survival_histogram);
+        os << ',';
+        write_list(os, aggregate.eliminated_by_round);
+        os << '\n';
+    }
+}
+
+static void sweep_usage() {
+    cerr << "Usage: animal_world --sweep --param NAME=VALUES... [--random N [--search-seed N]]"
+         << " [--engine actor|class] [--seeds BEGIN:END | --games N] [--threads N] [--block N]"
+         << " [--names FILE] [--output FILE]" << endl;
+    cerr << "NAME is stones, scissors, papers, cards, stars, safe-stars, eliminated-stars, actors or rounds;"
+         << " VALUES is A,B,C or FIRST:LAST or FIRST:LAST:STEP" << endl;
+}
+
+// NAME=A,B,C or NAME=FIRST:LAST[:STEP], every value checked against set_parameter
+static bool parse_parameter(const char* text, SweepParameter& parameter) {
+    const char* equals = strchr(text, '=');
+    if (equals == nullptr) return false;
+    parameter.name = string(text, equals);
+    string values = equals + 1;
+
+    try {
+        if (values.find(':') != string::npos) {
+            int range[3] = {0, 0, 1};
+            size_t count = 0;
+            size_t begin = 0;
+            while (count < 3) {
+                size_t end = values.find(':', begin);
+                range[count++] = std::stoi(values.substr(begin, end - begin));
+                if (end == string::npos) break;
+                begin = end + 1;
+            }
+            if (count < 2 || range[2] <= 0 || range[0] > range[1]) return false;
+            for (int value = range[0]; value <= range[1]; value += range[2])
+                parameter.values.push_back(value);
+        } else {
+            size_t begin = 0;
+            while (true) {
+                size_t end = values.find(',', begin);
+                parameter.values.push_back(std::stoi(values.substr(begin, end - begin)));
+                if (end == string::npos) break;
+                begin = end + 1;
+            }
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+
+    SimulationConfig probe;
+    for (int value : parameter.values)
+        if (!set_parameter(probe, parameter.name, value)) return false;
+    return !parameter.values.empty();
+}
+
+int run_sweep(int argc, char** argv) {
+    SweepConfig config;
+    unsigned game_count = 0;
+    string names_file = "names.txt";
+    string output_file;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+        if (strcmp(arg, "--sweep") == 0) continue;
+        if (value == nullptr) {
+            sweep_usage();
+            return 1;
+        }
+
+        if (strcmp(arg, "--param") == 0) {
+            SweepParameter parameter;
+            if (!parse_parameter(value, parameter)) {
+                cerr << "Bad parameter: " << value << endl;
+                sweep_usage();
+                return 1;
+            }
+            config.parameters.push_back(parameter);
+        } else if (strcmp(arg, "--engine") == 0) {
+            if (strcmp(value, "actor") == 0) config.base.engine = Engine::ACTOR;
+            else if (strcmp(value, "class") == 0) config.base.engine = Engine::HAND_CLASS;
+            else {
+                sweep_usage();
+                return 1;
+            }
+        } else if (strcmp(arg, "--random") == 0) config.random_count = std::stoul(value);
+        else if (strcmp(arg, "--search-seed") == 0) config.search_seed = std::stoul(value);
+        else if (strcmp(arg, "--threads") == 0) config.base.thread_count = std::stoi(value);
+        else if (strcmp(arg, "--block") == 0) config.block_size = std::stoul(value);
+        else if (strcmp(arg, "--names") == 0) names_file = value;
+        else if (strcmp(arg, "--output") == 0) output_file = value;
+        else if (strcmp(arg, "--games") == 0) game_count = std::stoul(value);
+        else if (strcmp(arg, "--seeds") == 0) {
+            const char* colon = strchr(value, ':');
+            if (colon == nullptr) {
+                sweep_usage();
+                return 1;
+            }
+            config.base.seed_begin = std::stoul(string(value, colon));
+            config.base.seed_end = std::stoul(string(colon + 1));
+        } else {
+            sweep_usage();
+            return 1;
+        }
+        ++i;
+    }
+    if (game_count > 0) config.base.seed_end = config.base.seed_begin + game_count;
+
+    auto configs = sweep_configurations(config);
+    for (auto& each : configs) {
+        if (card_counts_fit(each)) continue;
+        cerr << "Too many cards in play: " << each.actor_count << " actors of " << each.rules.stone_count << '/'
+             << each.rules.scissor_count << '/' << each.rules.paper_count << endl;
+        return 1;
+    }
+
+    // Every configuration takes the names of its actors from the front of the same pool
+    NamePool pool;
+    vector<std::string_view> names;
+    if (config.base.engine == Engine::ACTOR) {
+        int actor_count = 0;
+        for (auto& each : configs)
+            actor_count = std::max(actor_count, each.actor_count);
+        pool = NamePool(names_file);
+        if (!pool.is_open()) cerr << "Cannot open " << names_file << ", actors stay nameless" << endl;
+        names = pool.first(actor_count);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto aggregates = sweep(config, configs, names);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    long long total_games = 0;
+    for (auto& aggregate : aggregates)
+        total_games += aggregate.game_count;
+
+    if (output_file.empty()) {
+        write_sweep_csv(cout, configs, aggregates);
+    } else {
+        std::ofstream fs{output_file};
+        write_sweep_csv(fs, configs, aggregates);
+        if (!fs) {
+            cerr << "Cannot write the sweep to " << output_file << endl;
+            return 1;
+        }
+    }
+
+    cerr << "Swept " << configs.size() << " configurations, " << total_games << " games in " << elapsed.count()
+         << " s (" << (double) total_games / elapsed.count() << " games/s)" << endl;
+    return 0;
+}
@@ -0,0 +1,103 @@
+#ifndef ANIMAL_WORLD_SWEEP_H
+#define ANIMAL_WORLD_SWEEP_H
+
+#include "simulate.h"
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <map>
+#include <ostream>
+
+// One parameter of the game and the values a sweep tries for it
+struct SweepParameter {
+    std::string name;
+    std::vector<int> values;
+};
+
+// Quantiles of a stream of values in [0, inf) to within a relative error, from counts of logarithmic
+// buckets. Sketches of the same accuracy merge by adding their counts, in any order.
+class QuantileSketch {
+public:
+    QuantileSketch() : QuantileSketch(0.01) {}
+
+    explicit QuantileSketch(double relative_error);
+
+    void add(double value);
+
+    void merge(const QuantileSketch& other);
+
+    [[nodiscard]] long long count() const { return total; }
+
+    // The value of rank q * (count - 1) among those added, for q in [0, 1]; 0 when empty
+    [[nodiscard]] double quantile(double q) const;
+
+private:
+    double gamma;
+    double log_gamma;
+
+    long long total = 0;
+    long long zero_count = 0;
+    // Bucket i counts the values in (gamma^(i-1), gamma^i]
+    std::map<int, long long> buckets;
+};
+
+// What the games of one configuration add up to. Each game is folded in as it ends, and none is kept.
+struct SweepAggregate {
+    static constexpr int survival_bins = 20;
+
+    long long game_count = 0;
+    long long actor_total = 0;
+    long long safe_count = 0;
+    long long eliminated_count = 0;
+    long long unfinished_count = 0;
+
+    // Games by the fraction of their actors that ended safe, in equal bins over [0, 1]
+    std::vector<long long> survival_histogram = std::vector<long long>(survival_bins);
+    QuantileSketch survival_quantiles;
+
+    // Actors eliminated in each round, over every game
+    std::vector<long long> eliminated_by_round;
+
+    // Fold in a game whose eliminations by round were already added to eliminated_by_round
+    void add(const GameResult& result, int actor_count);
+
+    void merge(const SweepAggregate& other);
+};
+
+struct SweepConfig {
+    // The engine, seeds and threads, and the value of every parameter that is not swept
+    SimulationConfig base;
+
+    std::vector<SweepParameter> parameters;
+
+    // Draw this many configurations, each taking a random value of every parameter, instead of the whole grid
+    size_t random_count = 0;
+    unsigned search_seed = 0;
+
+    // Games of one configuration a worker plays in a row
+    size_t block_size = 16;
+};
+
+// Set a parameter by name: stones, scissors, papers, cards (all three), stars, safe-stars, eliminated-stars,
+// actors or rounds. Fails for unknown names and for values the game cannot be played with.
+bool set_parameter(SimulationConfig& config, std::string_view name, int value);
+
+// Every combination of the parameter values, the first parameter varying slowest, or random_count draws
+std::vector<SimulationConfig> sweep_configurations(const SweepConfig& sweep);
+
+// Play every seed of sweep.base in every configuration, as (configuration, block of seeds) units stolen
+// between the workers. Each worker folds its games into an aggregate of its own, merged into the result
+// whenever it moves on to another configuration.
+// names must cover the largest actor count, or be empty.
+std::vector<SweepAggregate> sweep(const SweepConfig& sweep, const std::vector<SimulationConfig>& configs,
+                                  const std::vector<std::string_view>& names);
+
+// A header and one CSV line per configuration
+void write_sweep_csv(std::ostream& os, const std::vector<SimulationConfig>& configs,
+                     const std::vector<SweepAggregate>& aggregates);
+
+// Entry point of `animal_world --sweep ...`
+int run_sweep(int argc, char** argv);
+
+#endif //ANIMAL_WORLD_SWEEP_H
@@ -0,0 +1,175 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <utility>
+#include <memory>
+
+ThreadPool::ThreadPool(int thread_count) {
+    if (thread_count <= 0) thread_count = (int) std::max(1u, std::thread::hardware_concurrency());
+
+    for (int i = 1; i < thread_count; ++i)
+        workers.emplace_back([this, i] { run_worker(i); });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    start_cv.notify_all();
+
+    for (auto& worker : workers)
+        worker.join();
+}
+
+void ThreadPool::parallel_for(size_t count, const Task& task, size_t grain) {
+    if (count == 0) return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->task = &task;
+        task_count = count;
+        task_grain = std::max<size_t>(grain, 1);
+        next_index = 0;
+        busy_count = (int) workers.size();
+        ++generation;
+    }
+    start_cv.notify_all();
+
+    drain(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done_cv.wait(lock, [this] { return busy_count == 0; });
+    this->task = nullptr;
+}
+
+void ThreadPool::parallel_for_stealing(size_t count, const Task& task) {
+    // The indices [begin, end) a worker has left; the owner takes from the front, thieves from the back
+    struct Share {
+        std::mutex mutex;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    size_t share_count = size();
+    auto shares = std::make_unique<Share[]>(share_count);
+    for (size_t i = 0; i < share_count; ++i) {
+        shares[i].begin = count * i / share_count;
+        shares[i].end = count * (i + 1) / share_count;
+    }
+
+    parallel_for(share_count, [&](size_t own_index, int worker) {
+        auto& own = shares[own_index];
+        while (true) {
+            size_t index = 0;
+            bool found = false;
+            {
+                std::lock_guard<std::mutex> lock(own.mutex);
+                if (own.begin < own.end) {
+                    index = own.begin++;
+                    found = true;
+                }
+            }
+            if (found) {
+                task(index, worker);
+                continue;
+            }
+
+            // Sizes may change before the steal; a victim found empty by then just means another look
+            size_t victim = share_count;
+            size_t victim_left = 0;
+            for (size_t i = 0; i < share_count; ++i) {
+                std::lock_guard<std::mutex> lock(shares[i].mutex);
+                size_t left = shares[i].end - shares[i].begin;
+                if (left > victim_left) {
+                    victim = i;
+                    victim_left = left;
+                }
+            }
+            if (victim == share_count) return;
+
+            size_t begin, end;
+            {
+                std::lock_guard<std::mutex> lock(shares[victim].mutex);
+                auto& other = shares[victim];
+                end = other.end;
+                begin = other.begin + (other.end - other.begin) / 2;
+                other.end = begin;
+            }
+            std::lock_guard<std::mutex> lock(own.mutex);
+            own.begin = begin;
+            own.end = end;
+        }
+    });
+}
+
+void ThreadPool::run_worker(int worker) {
+    unsigned seen_generation = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            start_cv.wait(lock, [&] { return stopping || generation != seen_generation; });
+            if (stopping) return;
+            seen_generation = generation;
+        }
+
+        drain(worker);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--busy_count == 0) done_cv.notify_one();
+        }
+    }
+}
+
+void ThreadPool::drain(int worker) {
+    while (true) {
+        size_t begin = next_index.fetch_add(task_grain);
+        if (begin >= task_count) break;
+
+        size_t end = std::min(begin + task_grain, task_count);
+        for (size_t i = begin; i < end; ++i)
+            (*task)(i, worker);
+    }
+}
+
+TaskQueue::TaskQueue(int thread_count) {
+    if (thread_count <= 0) thread_count = (int) std::max(1u, std::thread::hardware_concurrency());
+
+    for (int i = 0; i < thread_count; ++i)
+        workers.emplace_back([this] { run_worker(); });
+}
+
+TaskQueue::~TaskQueue() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    ready_cv.notify_all();
+
+    for (auto& worker : workers)
+        worker.join();
+}
+
+void TaskQueue::push(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    ready_cv.notify_one();
+}
+
+void TaskQueue::run_worker() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready_cv.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (tasks.empty()) return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
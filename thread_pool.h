@@ -0,0 +1,85 @@
+#ifndef ANIMAL_WORLD_THREAD_POOL_H
+#define ANIMAL_WORLD_THREAD_POOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <deque>
+
+// A fixed set of workers; the calling thread takes part as worker 0
+class ThreadPool {
+public:
+    using Task = std::function<void(size_t index, int worker)>;
+
+    // Zero means one worker per hardware thread
+    explicit ThreadPool(int thread_count = 0);
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    [[nodiscard]] int size() const { return (int) workers.size() + 1; }
+
+    // Run task for every index in [0, count), handing out `grain` indices at a time; blocks until all are done
+    void parallel_for(size_t count, const Task& task, size_t grain = 1);
+
+    // parallel_for where every worker starts on its own contiguous share of the indices and, once that runs
+    // out, steals the upper half of the largest share left. Suits tasks of very different costs, where
+    // neighbouring indices are alike and worth running on the same worker.
+    void parallel_for_stealing(size_t count, const Task& task);
+
+private:
+    void run_worker(int worker);
+
+    void drain(int worker);
+
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable start_cv;
+    std::condition_variable done_cv;
+
+    const Task* task = nullptr;
+    size_t task_count = 0;
+    size_t task_grain = 1;
+    std::atomic<size_t> next_index{0};
+
+    int busy_count = 0;
+    unsigned generation = 0;
+    bool stopping = false;
+};
+
+// Workers that each take the oldest task queued and run it, for independent jobs handed in one at a time
+class TaskQueue {
+public:
+    // Zero means one worker per hardware thread
+    explicit TaskQueue(int thread_count = 0);
+
+    // Runs the tasks still queued before returning
+    ~TaskQueue();
+
+    TaskQueue(const TaskQueue&) = delete;
+
+    TaskQueue& operator=(const TaskQueue&) = delete;
+
+    [[nodiscard]] int size() const { return (int) workers.size(); }
+
+    void push(std::function<void()> task);
+
+private:
+    void run_worker();
+
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable ready_cv;
+    std::deque<std::function<void()>> tasks;
+    bool stopping = false;
+};
+
+#endif //ANIMAL_WORLD_THREAD_POOL_H
@@ -0,0 +1,39 @@
+#include "event_trace.h"
+#include "game.h"
+
+#include <iostream>
+#include <cstdio>
+
+using std::cerr;
+using std::endl;
+using std::vector;
+
+static const char* card_name(uint8_t card) {
+    if (card > (uint8_t) Card::PAPER) return "";
+    static const char* names[3] = {"stone", "scissor", "paper"};
+    return names[card];
+}
+
+// Print a trace as CSV, one event per line
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        cerr << "Usage: animal_world_trace TRACE_FILE > events.csv" << endl;
+        return 1;
+    }
+
+    EventTraceReader reader(argv[1]);
+    if (!reader.is_open()) {
+        cerr << "Cannot read a trace from " << argv[1] << endl;
+        return 1;
+    }
+
+    // Millions of lines are expected, so they go through stdio's buffer rather than cout with endl
+    printf("game,round,event,actor,other,card,other_card,value\n");
+    vector<Event> events;
+    while (reader.next(events)) {
+        for (auto& event : events)
+            printf("%u,%u,%s,%d,%d,%s,%s,%d\n", event.game, (unsigned) event.round, event_name(event.type),
+                   event.actor, event.other, card_name(event.card), card_name(event.other_card), event.value);
+    }
+    return 0;
+}